@@ -23,6 +23,7 @@
 #include "FullHist.h"
 #include "UnitRules.h"
 #include "ExtPos.h"
+#include "WordPlistCache.h"
 
 #define Termstar const Term*
 
@@ -34,6 +35,8 @@ struct Wwegt
 };
 
 class Bchart;
+class DecodePool;
+class LeftRightGotIter;
 
 /* WordAndPresence stores the integer associated with a word and whether
    the word is a "hole" or not (false = hole).  ("hole"s are in the
@@ -56,14 +59,26 @@ public:
     int     extraTime; //if no parse is found on regular time;
     static  Item*    dummyItem;
     static float timeFactor;
+    /* parse() pops up to edgeBatch edges off the agenda before scoring the
+       edges they create, together and (with sentenceThreads > 1) in
+       parallel.  1 scores each edge as it is created. */
+    static int edgeBatch;
+    /* threads working on each sentence: scoring edgeBatch batches and
+       MeChart::findMapParse() */
+    static int sentenceThreads;
+    /* 0 for the best-first search over the whole sentence; otherwise the
+       most edges popped for each span, searching span by span (see
+       spanSearch()) */
+    static int beamWidth;
     float    denomProbs[MAXSENTLEN];  
+    FullHistPool fullHistPool;
     void            check();
     static void     setPosStarts();
     ECString intToW(int n);
     bool prned();
     bool issprn(Edge* e);
     static map< ECString, WordAndPresence, less<ECString> > wordMap;
-    static ECString invWordMap[MAXNUMWORDS];
+    static vector<ECString> invWordMap;
   static int lastKnownWord;
   static int lastWord[MAXNUMTHREADS];
   static map<ECString, int> newWordMap[MAXNUMTHREADS];
@@ -83,6 +98,13 @@ public:
   // 06/01/06 ML: made these methods public for access by parseIt.C
   // in getting at least POS tags when parsing fails.
   list<float>& wordPlist(Wrd* word, int word_num);
+  /* The active model's cache of wordPlist()s.  initWordPlists() loads
+     wordPlists.txt from the model directory if it is there and otherwise
+     fills the cache for the known vocabulary.  saveWordPlists() writes
+     the cache (including the unknown words seen so far) in that format. */
+  static WordPlistCache wordPlistCache;
+  static void initWordPlists(ECString path);
+  static bool saveWordPlists(ECString filename);
   static float& pT(int val)
     {
       if (val < 0 || val >= MAXNUMNTTS)
@@ -126,7 +148,8 @@ public:
     void            add_reg_item(Item * itm);
     void            addFinishedEdge(Edge* newEdge);
     void            add_starter_edges(Item* itm);
-    float           meEdgeProb(const Term* trm, Edge* edge, int whichInt);
+    float           meEdgeProb(const Term* trm, Edge* edge, int whichInt,
+			       LeftRightGotIter* gi);
     float           meFHProb(const Term* trm, FullHist& fh, int whichInt);
     static int printDebug_;
 
@@ -138,29 +161,50 @@ public:
     void            addWordsToKeylist( );
     Item           *in_chart(const Wrd* hd, const Term * trm,
 			     int start, int finish);
-    bool            repeatRule(Edge* edge);
+    bool            repeatRule(Edge* edge, LeftRightGotIter* gi);
+    void            scoreEdge(Edge* newEdge, Item* item, int right,
+			      bool headEdge);
+    void            insertEdge(Edge* newEdge, Item* item, bool batched);
+    void            scorePending(DecodePool* pool);
+    void            bestFirstSearch(DecodePool* pool);
+    void            spanSearch(DecodePool* pool);
+    void            dropUnpopped();
+    void            scoreSpan(DecodePool* pool);
+    bool            usePopped(Edge* edge);
+    void            extendPopped(Edge* edge);
+    void            agendaInsert(Edge* edge);
+    void            retire(Edge* edge);
+    int             spanIndex(int start, int finish) const
+		      { return start*(wrd_count_+1) + finish; }
 
     void            redoP(Edge* edge, double probRatio);
     void            redoP(Item *item, double probDiff);
 
-    float           computeMerit(Edge* edge, int whichCalc);
+    float           computeMerit(Edge* edge, int whichCalc,
+				 LeftRightGotIter* gi);
 
     void  initDenom();
-    double  psktt(Wrd* shU, int t);
+    int     capClass(const Wrd* shU);
+    static void lexicalPlist(const ECString& wordL, int wint, int capClass,
+			     list<float>& ans, Bchart* guide = NULL,
+			     int word_num = 0);
+    static double  psktt(int wint, int capClass, int t);
     double  pCapgt(const Wrd* shU, int t);
-    float   pHst(int w, int t);
+    static double  pCapgt(int capClass, int t);
+    static float   pHst(int w, int t);
     double  psutt(const Wrd* shU, int t);
-    float   pegt(ECString& sh, int t);
+    static double  psutt(const ECString& shL, int capClass, int t);
+    static float   pegt(const ECString& sh, int t);
     void    getpHst(const ECString& hd, int t);
-    double pHypgt(const ECString& shU, int t);
+    static double pHypgt(const ECString& shU, int t);
     static float&  pHcapgt(int i) { return pHcapgt_[i]; }
     static float&  pHhypgt(int i) { return pHhypgt_[i]; }
     static float&  pHugt(int i) { return pHugt_[i]; }
 
     int     bucket(float val, int whichInt, int whichFt);
     int     bucket(float val);
-    int    greaterThan(Wwegt& wwegt, ECString e, int t);
-    float  pHegt(ECString& es, int t);
+    static int    greaterThan(Wwegt& wwegt, const ECString& e, int t);
+    static float  pHegt(const ECString& es, int t);
     float  computepTgT(int t1,int t2);
     void   addToDemerits(Edge* edge);
     static Item*    stops[MAXSENTLEN];
@@ -170,7 +214,28 @@ public:
     static int&     posStarts(int i, int j);
     static int      posStarts_[MAXNUMNTTS][MAXNUMNTS];
   int     curDemerits_[MAXSENTLEN][MAXSENTLEN];
-
+  /* the edges extend_rule() created for the current batch, in order */
+  struct PendingEdge
+  {
+    Edge* edge;
+    Item* item;
+    int right;
+    bool headEdge;
+  };
+  vector<PendingEdge> pendingEdges_;
+  bool batching_;
+  /* for spanSearch(): the span being searched, the scored and unscored
+     edges over each span still to come, and the edges done with (see
+     retire()) */
+  int curStart_;
+  int curFinish_;
+  vector<vector<Edge*> > spanEdges_;
+  vector<vector<PendingEdge> > spanPending_;
+  static bool betterEstimate(const PendingEdge& a, const PendingEdge& b);
+  vector<Edge*> retired_;
+  friend class EdgeScoreTask;
+
+  friend class ParserModel;
   static int egtSize_;
   static float bucketLims[14];
   static float pT_[MAXNUMNTTS];
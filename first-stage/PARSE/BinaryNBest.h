@@ -0,0 +1,55 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.  You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef BINARYNBEST_H
+#define BINARYNBEST_H
+
+#include <iostream>
+#include <vector>
+#include "ECString.h"
+#include "InputTree.h"
+
+/*
+ * The binary n-best format (parseIt -b) stores a sentence's n-best list
+ * much more compactly than the text format.  Every distinct label and
+ * word is stored once, and every distinct subtree is stored once as a
+ * node, so the many subtrees the parses of a sentence have in common
+ * are shared.  A sentence is:
+ *
+ *   BINARY_NBEST_MAGIC BINARY_NBEST_VERSION
+ *   label:string
+ *   nstrings:uint string*                   labels and words
+ *   nnodes:uint node*
+ *   nparses:uint (logprob:double root:uint)*
+ *
+ * where a uint is unsigned LEB128 (7 bits per byte, low bits first), a
+ * string is its length (uint) and bytes, and a double is 8 bytes of
+ * IEEE 754 in little endian order.  A node is (label << 1 | 1) and the
+ * word if it is a preterminal, otherwise (label << 1), the number of
+ * children and the children.  Labels, words and children are indexes
+ * into the tables above and children always come before their parents.
+ *
+ * Sentences follow each other with nothing in between.  The reranker
+ * (sp-data.h) and the Python NBestList read this as well as the text
+ * format, telling them apart by the first byte of each sentence.
+ */
+
+const unsigned char BINARY_NBEST_MAGIC = 0x02;
+const unsigned char BINARY_NBEST_VERSION = 1;
+
+void writeBinaryNBest(ostream& os, const ECString& label,
+		      const vector<double>& logProbs,
+		      const vector<InputTree*>& trees);
+
+#endif /* ! BINARYNBEST_H */
@@ -35,6 +35,8 @@ class Val
 {
  public:
   static Val* newIth(int ith, Val* oval, bool& stop);
+  /* how many Vals newIth() has made on the calling thread */
+  static long numCopies();
   Val() : status(NORMALVAL), len_(1), prob_(0), edge_(NULL), trm_(-1), wrd_(-1)
     {
       vec_.push_back(0);
@@ -22,6 +22,7 @@
 #include "SentRep.h"
 #include "Feature.h"
 #include <vector>
+#include <atomic>
 
 class InputTree;
 
@@ -44,6 +45,13 @@ public:
     int             poppedEdgeCount() const    { return poppedEdgeCount_; }
     int             poppedEdgeCountAtS() const    { return poppedEdgeCountAtS_; }
     int             totEdgeCountAtS() const    { return totEdgeCountAtS_; }
+    /* roughly the bytes of edges, items and decoding state (Bsts and
+       Vals) this parse has allocated */
+    long            memUsed() const;
+    /* true if the parse went over memLimit, so that its search or
+       decoding was cut short */
+    bool            memCapped() const;
+    static long     memLimit;  // bytes a parse may use, 0 for no limit
     Item*           addtochart(const Term* trm);
     // printing information about the parse.
     const Item*     mapProbs();
@@ -85,6 +93,11 @@ protected:
     static int      ruleiCountTimeout_ ; //how many rulei's before we time out.
     static int      poppedTimeout_;
     float           endFactorComp(Edge* dnrl);
+    void            charge(long bytes);
+    bool            overMem(double share);
+    // atomic since decoding tasks charge concurrently
+    std::atomic<long> memUsed_;
+    std::atomic<bool> memCapped_;
 
 private:
     void            free_chart_items(Items& itms);
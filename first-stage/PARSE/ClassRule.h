@@ -48,6 +48,7 @@ class ClassRule
   int m_;
   int rel_;
   int d_;
+  friend class ParserModel;
   static vector<ClassRule>  rBundles2_[MAXNUMNTTS][MAXNUMNTS];
   static vector<ClassRule>  rBundles3_[MAXNUMNTTS][MAXNUMNTS];
   static vector<ClassRule>  rBundlesm_[MAXNUMNTTS][MAXNUMNTS];
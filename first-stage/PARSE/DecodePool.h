@@ -0,0 +1,99 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.  You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DECODEPOOL_H
+#define DECODEPOOL_H
+
+#include <pthread.h>
+#include <deque>
+#include <map>
+#include <vector>
+#include "Bst.h"
+#include "Item.h"
+#include "FullHist.h"
+
+/* the most threads one DecodePool runs, counting the caller */
+#define MAXDECODETHREADS 64
+
+struct DecodeWorker;
+
+/* A piece of one sentence's parsing that can run on any of a
+   DecodePool's threads. */
+class DecodeTask
+{
+ public:
+  DecodeTask() : parent(NULL), done(false) {}
+  virtual ~DecodeTask() {}
+  virtual void run(FullHistPool& pool) {}
+  DecodeTask* parent;  // the task that forked this one
+  bool done;
+};
+
+/*
+ * A DecodePool runs the work on one sentence (the Bst computations of its
+ * n-best decoding, or a batch of edges to score; see Bchart::edgeBatch) on
+ * several threads.  A task forks subtasks with runAll(), which queues
+ * them on the forking thread's deque and runs them there while idle
+ * threads steal from the other end.  A thread waiting on its subtasks only
+ * runs those, never unrelated work, so a task can't end up waiting under
+ * something that waits for it.
+ *
+ * Because the Bsts are memoized on the chart's items, which every task
+ * shares, lookups go through the pool as well.  claim() hands each Bst to
+ * the first task needing it; the rest wait for it to be finished.
+ */
+class DecodePool
+{
+ public:
+  DecodePool(int numThreads);
+  ~DecodePool();
+  /* Runs tasks (children of the calling task) and returns when they are
+     all done. */
+  void runAll(vector<DecodeTask*>& tasks);
+  /* The FullHistPool the calling thread's histories come from. */
+  FullHistPool& histPool();
+
+  /* itm->stored(ca) and bstFind(ca, bm), safe to call from any task */
+  Bst& stored(Item* itm, CntxArray& ca);
+  Bst& find(CntxArray& ca, BstMap& bm);
+  /* itm->posAndheads()[pos][wd] */
+  ItmGHeadInfo& headInfo(Item* itm, int pos, const Wrd& wd);
+  /* Returns true if the calling task should compute bst, and then must
+     call finish(bst).  Otherwise bst has been computed, or (as when
+     decoding serially) is being computed by the calling task or one of
+     its ancestors, and is used as it stands. */
+  bool claim(Bst& bst);
+  void finish(Bst& bst);
+ private:
+  DecodePool(const DecodePool&);
+  DecodePool& operator=(const DecodePool&);
+  static void* workerLoop(void* arg);
+  void work();
+  void runTask(DecodeTask* task);
+  DecodeTask* steal(int index);
+  bool isAncestor(DecodeTask* task, DecodeTask* desc);
+  DecodeTask* current();
+
+  int numThreads_;
+  DecodeWorker* workers_;
+  vector<deque<DecodeTask*> > deques_;
+  vector<FullHistPool*> histPools_;
+  map<Bst*, DecodeTask*> inProgress_;
+  DecodeTask root_;  // stands for the caller's own decoding
+  bool stopping_;
+  pthread_mutex_t lock_;
+  pthread_cond_t changed_;
+};
+
+#endif /* ! DECODEPOOL_H */
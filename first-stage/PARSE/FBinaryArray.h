@@ -19,20 +19,67 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 class Feat;
 class FeatureTree;
 
+/* the most codebooks (one per calculation, see Feature::whichInt) */
+#define MAXNUMCODEBOOKS 20
+
+/*
+ * A FeatCodebook holds the values a quantized FBinaryArray's features
+ * can take: at most 2^bits of them, chosen by 1-d k-means on the log of
+ * the values they stand for (or all of them if there are no more).
+ */
+class FeatCodebook
+{
+ public:
+  void build(std::vector<float>& vals, int bits);
+  int code(float val) const;
+  float value(int c) const { return values_[c]; }
+  int size() const { return values_.size(); }
+  void swap(FeatCodebook& other) { values_.swap(other.values_); }
+ private:
+  std::vector<float> values_;   // increasing
+};
+
+/*
+ * An FBinaryArray holds a FeatureTree node's Feats, sorted by ind().
+ * Once pack()ed it no longer holds Feats: the inds are stored as offsets
+ * from the first one (in 16 bits when they fit) and the values as 8 or
+ * 16 bit codes into the codebook of the array's calculation.  Either way
+ * find(), ind() and g() read it.
+ */
 class FBinaryArray
 {
  public:
-  FBinaryArray() : size_(0) {}
+  FBinaryArray() : size_(0), bits_(0), wide_(0), calc_(0), array_(NULL) {}
   void set(int sz);
-  Feat*   find(const int id) const;
+  /* the position of the Feat whose ind() is id, or -1 */
+  int     find(const int id) const;
   int     size() const { return size_; }
+  int     ind(int i) const;
+  float   g(int i) const;
+  /* the i'th Feat, which only an array that isn't packed has */
   Feat*   index(int i);
+  /* replaces the Feats with codes into codebook(calc), which holds
+     their values */
+  void    pack(int bits, int calc);
+  /* the bytes allocated for the features */
+  size_t  bytes() const;
+  static FeatCodebook& codebook(int calc) { return codebooks_[calc]; }
   int size_;
-  Feat* array_;
+  unsigned char bits_;    // 0 if not packed, else 8 or 16
+  unsigned char wide_;    // inds are 32 bit offsets
+  unsigned char calc_;
+  union {
+    Feat* array_;
+    unsigned char* packed_;  // first ind, then the offsets, then the codes
+  };
+ private:
+  friend class ParserModel;
+  static FeatCodebook codebooks_[MAXNUMCODEBOOKS];
 };
 
 class FTreeBinaryArray
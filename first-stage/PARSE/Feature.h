@@ -92,6 +92,7 @@ class SubFeature
   static int      ufArray[MAXNUMCALCS][MAXNUMFS];
   static int      splitPts[MAXNUMCALCS][MAXNUMFS];
  private:
+  friend class ParserModel;
   static SubFeature* array_[MAXNUMCALCS][MAXNUMFS];
 };
 
@@ -147,6 +148,7 @@ class Feature
   static void  createFTypeTree(FTypeTree* ft, int n, int which);
   static float logFacs[MAXNUMCALCS][MAXNUMFS];
  private:
+  friend class ParserModel;
   static Feature* array_[MAXNUMCALCS][MAXNUMFS];
   static float* lambdas_[MAXNUMCALCS][MAXNUMFS];
 };
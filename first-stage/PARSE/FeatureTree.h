@@ -56,6 +56,12 @@ public:
   FeatureTree* follow(int val, int auxCnt);
   static FeatureTree* roots(int which) { return roots_[which]; }
   void         printFfCounts(int asVal, int depth, ostream& os);
+  /* packs the feature values of roots(which) into quantBits bits, with
+     a codebook built from them (see FBinaryArray::pack) */
+  static void  quantize(int which);
+  /* the bytes this node and those under it use for their Feats */
+  size_t       featBytes() const;
+  static int   quantBits;  // 0 (don't quantize), 8 or 16
   friend ostream&  operator<<(ostream& os, const FeatureTree& ft);
 
   int ind() const { return ind_; }
@@ -67,9 +73,12 @@ public:
    FBinaryArray feats;
   FTreeBinaryArray subtree;
  private:
+  friend class ParserModel;
   static FeatureTree* roots_[20];
   void othReadFeatureTree(istream& is, FTypeTree* ftt, int cnt);
   void printFfCounts2(int asVal, int depth, ostream& os);
+  void collectGs(vector<float>& gs) const;
+  void pack(int bits, int which);
 };
 
 #endif /* ! FEATURETREE_H */
@@ -16,33 +16,47 @@
 #define FULLHIST_H
 
 #include "Edge.h"
+#include "Feature.h"
 #include <list>
+#include <vector>
 #include "Wrd.h"
 #include <iostream>
 #include <fstream>
 #include "ECString.h"
 
 class FullHist;
+class FullHistPool;
 class Bchart;
+class LeftRightGotIter;
 typedef list<FullHist*>::iterator FullHistIter;
 
 class
 FullHist
 {
 public:
-  FullHist() : cpos(0), e(NULL), back(NULL),hd(NULL),cb(NULL) {}
-    FullHist(Edge* e1) : cpos(0), e(e1), back(NULL),cb(NULL){}
+  FullHist() : cpos(0), e(NULL), back(NULL),hd(NULL),cb(NULL),
+    fharray(NULL), size(0), index(0), pool(NULL), gi(NULL), subfKnown(0) {}
+    FullHist(Edge* e1) : cpos(0), e(e1), back(NULL),cb(NULL),
+    fharray(NULL), size(0), index(0), pool(NULL), gi(NULL), subfKnown(0) {}
   FullHist(int tint, Bchart* cb)
-    : cpos(0), term(tint), back(NULL), pos(-1), hd(NULL), cb(cb){}
-  FullHist(int tint, FullHist* fh, Item* i)
-    : cpos(0), itm(i), term(tint), back(fh), pos(-1),hd(NULL),cb(fh->cb){}
+    : cpos(0), term(tint), back(NULL), pos(-1), hd(NULL), cb(cb),
+    fharray(NULL), size(0), index(0), pool(NULL), gi(NULL), subfKnown(0) {}
+  FullHist(int tint, FullHist* fh, Item* i, int idx)
+    : cpos(0), itm(i), term(tint), back(fh), pos(-1),hd(NULL),cb(fh->cb),
+    fharray(NULL), size(0), index(idx), pool(fh->pool), gi(NULL),
+    subfKnown(0) {}
   FullHist* extendByEdge(Edge* e1);
   FullHist* extendBySubConstit();
   FullHist* retractByEdge();
+  /* the value of subfeature function usf (SubFeature::usf) for this
+     history.  Those fixed once the history is built (ones looking at its
+     parent, grandparent and siblings) are computed on first use and then
+     shared by every distribution. */
+  int subFeature(int usf);
   FullHist* nth(int n)
     {
       if(n < 0 || n >= size) return NULL;
-      else return fharray[n];
+      else return &fharray[n];
     }
   friend ostream& operator<<(ostream& os, const FullHist& fh);
   int cpos;
@@ -55,8 +69,42 @@ public:
   Bchart* cb;
   int hpos;
   int preTerm;
-  FullHist* fharray[400];
+  FullHist* fharray;  // the size children, which live in histPool()
   int size;
+  int index;  // which of back's children this is
+  /* where children are allocated; NULL for cb's fullHistPool.  Histories
+     extended on a DecodePool's threads use that thread's pool. */
+  FullHistPool* pool;
+  LeftRightGotIter* gi;  // the rule being scored by MeChart::meRuleProb()
+  FullHistPool& histPool();
+ private:
+  unsigned subfKnown;  // bit usf set when subfVals[usf] holds its value
+  int subfVals[MAXNUMFS];
+};
+
+/* The children of the histories being extended during decoding.  Histories
+   are extended and retracted in stack order, so a chart keeps all of its
+   histories' children in one pool of blocks, handing out runs of exactly
+   the rule's arity and reclaiming them when the edge is retracted. */
+#define FULLHISTBLOCKSIZE 512
+
+class
+FullHistPool
+{
+public:
+  FullHistPool() : block_(0), top_(0) {}
+  ~FullHistPool();
+  FullHist* alloc(int n);
+  // releases fhs, which must be the most recent alloc() still held.
+  void release(FullHist* fhs);
+private:
+  FullHistPool(const FullHistPool&);
+  FullHistPool& operator=(const FullHistPool&);
+  vector<FullHist*> blocks_;
+  vector<int> blockSizes_;
+  vector<pair<int,int> > marks_;  // (block_, top_) before each alloc()
+  int block_;
+  int top_;
 };
 
 #endif
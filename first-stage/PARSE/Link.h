@@ -16,9 +16,11 @@
 #define LINKH
 
 #include <vector>
+#include <map>
 #include "ECString.h"
 
 class InputTree;
+class Val;
 
 #define DUMMYVAL 999
 
@@ -43,4 +45,24 @@ class Link
   Links links_;
 };
 
+/* The bracketings of the n-best parses output so far.  Like Link, it
+   tells whether a candidate parse differs from all of them in more than
+   its hidden annotations (heads etc.), but it reads the bracketing (the
+   sequence of terms Link::is_unique() walks) straight off the candidate's
+   Val, so a duplicate is rejected before any InputTree is built for it.
+   Bracketings are bucketed by a hash and compared exactly within their
+   bucket. */
+class UniqueParses
+{
+ public:
+  /* Returns true, and remembers v's bracketing, if it is new.  cnt is set
+     to the number of words in v. */
+  bool insert(Val* v, int& cnt);
+ private:
+  typedef vector<short> Bracketing;
+  static void bracketing(Val* v, Bracketing& br, int& cnt);
+  map<unsigned long long, vector<Bracketing> > seen_;
+  Bracketing br_;
+};
+
 #endif
@@ -24,20 +24,31 @@
 #include "Item.h"
 #include "Bst.h"
 
+/* p(w | w1 w2) for known-word trigrams, keyed by the three word ints
+   (see MeChart::triGram()).  Sentences scored with the same cache (e.g.,
+   candidates sharing a prefix) only compute each trigram once. */
+typedef map<unsigned long long, float> TriGramCache;
+
+class DecodePool;
+
 class MeChart : public Bchart
 {
  public:
   MeChart(SentRep & sentence,int id)
-    : Bchart( sentence,id ) {}
+    : Bchart( sentence,id ), decodePool(NULL) {}
   MeChart(SentRep & sentence,ExtPos& extpos,int id)
-    : Bchart( sentence,extpos,id ){}
-  double triGram();
+    : Bchart( sentence,extpos,id ), decodePool(NULL) {}
+  double triGram(TriGramCache* cache = NULL);
   static void init(ECString path);
   Bst& findMapParse();
+  Val* nextParse(Bst& bst, int n);
   Bst& bestParse(Item* itm, FullHist* h,Val* cat,Val* gcat,int cdir);
   Bst& bestParseGivenHead(int posInt, const Wrd& wd, Item* itm,
 				 FullHist* h,ItmGHeadInfo& ighInfo,
 				 Val* cat,Val* gcat);
+  Val* bestParseGivenEdge(Edge* e, int posInt, const Wrd& wd, Item* itm,
+			  FullHist* h, Val* cval, Val* gcval,
+			  double& nextPs, bool& zeroProb);
   void  fillInHeads();
   bool  headsFromEdges(Item* itm);
   bool  headsFromEdge(Edge* e);
@@ -48,6 +59,7 @@ class MeChart : public Bchart
   Bst& recordedBPGH(Item* itm, BstMap& atm, FullHist* h);
   float meHeadProb(int wInt, FullHist* h);
   float meProb(int val, FullHist* h, int which);
+  float triGramProb(int wInt, FullHist* h, TriGramCache* cache);
   float meRuleProb(Edge* e, FullHist* h);
   void  getRelFeats(int c, int c2, int which, Feat* relFeat[],
 		    FeatureTree* fts[], FullHist* h, int facPos);
@@ -57,6 +69,12 @@ class MeChart : public Bchart
   static void    initccarray(ifstream& is, float lenArray[6][8]);
   float   ccLenProb(Edge* edge, int effend);
   void    prDp();
+ private:
+  bool  claimBst(Bst& bst);
+  void  finishBst(Bst& bst);
+  void  setCurVals(Val* cval, Val* gcval);
+  void  setCurVals(Val* cval, Val* gcval, int cdir);
+  DecodePool* decodePool;  // while findMapParse() decodes in parallel
 };
 
 #endif
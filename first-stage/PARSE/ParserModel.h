@@ -0,0 +1,160 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.  You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef PARSERMODEL_H
+#define PARSERMODEL_H
+
+#include <pthread.h>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include "ECString.h"
+#include "Bchart.h"
+#include "ClassRule.h"
+#include "Feature.h"
+#include "FeatureTree.h"
+#include "Term.h"
+#include "headFinderCh.h"
+
+/*
+ * A ParserModel holds everything generalInit() loads from a model
+ * directory, so that one process can load several models (e.g., for
+ * different domains or languages) and switch between them.
+ *
+ * Charts read the model from class statics (Term, Feature, FeatureTree,
+ * Bchart, ClassRule, ...) and the head finder's tables, so only one
+ * model is active at a time: the active model's data is in those
+ * statics and the others' data is swapped out into their ParserModel
+ * objects.  This is not concurrent multi-model parsing: parses with
+ * different models never overlap, and a program which alternates
+ * between models spends its time waiting for swaps.  The settings a
+ * model was loaded with (language, -M, -X and -q) are part of it.
+ * Parser options (Bchart::Nth, timeFactor, ...) are shared by all
+ * models.
+ *
+ * Code which parses holds a ParserModel::User (or calls acquire() and
+ * release()) for the model it wants while it uses it.  Any number of
+ * threads can use the active model at once; using another model waits
+ * until the active model has no users and then swaps the two.  While a
+ * thread waits to swap (or to load a model), new users of the active
+ * model wait behind it.  Loading a model which is already loaded with
+ * the same settings returns the loaded one, so that users of the same
+ * model (e.g., several Python RerankingParsers) don't serialize.
+ */
+class ParserModel
+{
+ public:
+  /* Loads the model in path with the current settings (Term::Language,
+     Feature::isLM, ...), or finds the model already loaded from path
+     with those settings, and makes it the active model.  Waits until
+     the active model has no users. */
+  static ParserModel* load(ECString path);
+  static ParserModel* active() { return active_; }
+  const ECString& path() const { return path_; }
+  /* FeatureTree::quantBits when the model was loaded */
+  int quantBits() const { return quantBits_; }
+  static void acquire(ParserModel* model);
+  static void release();
+
+  class User
+  {
+  public:
+    User(ParserModel* model) { acquire(model); }
+    ~User() { release(); }
+  };
+
+ private:
+  ParserModel();
+  void swap();
+  static ECString settings(const ECString& path);
+
+  static ParserModel* active_;
+  static int users_;
+  static int swapsWaiting_;  // threads waiting for users_ to reach 0
+  static pthread_mutex_t lock_;
+  static pthread_cond_t idle_;
+  static list<ParserModel*> loaded_;
+
+  ECString path_;
+  ECString settings_;  // see settings()
+  int quantBits_;
+
+  // Term
+  Term* termArray_[MAXNUMNTTS];
+  TermMap termMap_;
+  int lastTagInt_;
+  int lastNTInt_;
+  const Term* stopTerm_;
+  const Term* startTerm_;
+  const Term* rootTerm_;
+  ECStrings finals_;
+  ECStrings colons_;
+  ECString language_;
+
+  // head finding (headFinder.C and headFinderCh.C)
+  set<ECString,less<ECString> > head1s_;
+  set<ECString,less<ECString> > head2s_;
+  vector<unsigned char> headTable_;
+  int headTableRows_;
+  int headTableCols_;
+  int ppInt_;
+  bool headTableCompiled_;
+  map<ECString,list<list<ECString> >,less<ECString> > hmap_;
+  vector<vector<HeadRuleCh> > headRulesCh_;
+
+  // Bchart
+  map<ECString, WordAndPresence, less<ECString> > wordMap_;
+  vector<ECString> invWordMap_;
+  int lastKnownWord_;
+  map<ECString, int> newWordMap_[MAXNUMTHREADS];
+  vector<ECString> newWords_[MAXNUMTHREADS];
+  UnitRules* unitRules_;
+  Item* stops_[MAXSENTLEN];
+  int posStarts_[MAXNUMNTTS][MAXNUMNTS];
+  int egtSize_;
+  float pT_[MAXNUMNTTS];
+  float pHcapgt_[MAXNUMTS];
+  float pHhypgt_[MAXNUMTS];
+  float pHugt_[MAXNUMTS];
+  Wwegt* pHegt_;
+  int nullWordInt_;
+  WordPlistCache wordPlistCache_;
+
+  // ClassRule (only loaded with -M or -X)
+  vector<ClassRule> rBundles2_[MAXNUMNTTS][MAXNUMNTS];
+  vector<ClassRule> rBundles3_[MAXNUMNTTS][MAXNUMNTS];
+  vector<ClassRule> rBundlesm_[MAXNUMNTTS][MAXNUMNTS];
+
+  // Feature, SubFeature and FeatureTree
+  bool isLM_;
+  bool useExtraConditioning_;
+  int numCalcs_;
+  int cntxArraySz_;
+  Feature* featureArray_[MAXNUMCALCS][MAXNUMFS];
+  int featureTotal_[MAXNUMCALCS];
+  float* lambdas_[MAXNUMCALCS][MAXNUMFS];
+  int conditionedFeatureInt_[MAXNUMCALCS];
+  FTypeTree ftTree_[MAXNUMCALCS];
+  FTypeTree* ftTreeFromInt_[MAXNUMCALCS][MAXNUMFS];
+  float logFacs_[MAXNUMCALCS][MAXNUMFS];
+  SubFeature* subFeatureArray_[MAXNUMCALCS][MAXNUMFS];
+  int subFeatureTotal_[MAXNUMCALCS];
+  int ufArray_[MAXNUMCALCS][MAXNUMFS];
+  int splitPts_[MAXNUMCALCS][MAXNUMFS];
+  FeatureTree* roots_[20];
+  FeatCodebook codebooks_[MAXNUMCODEBOOKS];
+};
+
+#endif /* ! PARSERMODEL_H */
@@ -17,19 +17,41 @@
 
 #include "InputTree.h"
 
+/*
+ * ScoreTree computes labeled bracket precision and recall.  A tree's
+ * constituents are packed into (label, start, end) Bracket keys, where
+ * start and end treat punctuation as part of the word before it, and
+ * collected into a sorted flat array, so scoring a parse against the gold
+ * brackets is one merge of two arrays.  A parse can be scored against
+ * gold brackets collected once, as when scoring an n-best list.
+ */
 class ScoreTree
 {
  public:
+  typedef long long Bracket;
+  typedef vector<Bracket> Brackets;
   int equivInt(int x);
   int puncEquiv(int i, vector<ECString>& sr);
   void setEquivInts(vector<ECString>& sr);
-  bool lexact2(InputTree* tree);
+  /* adds tree's brackets to trips (the gold brackets not yet matched) */
   void recordGold(InputTree* tree, ParseStats& parseStats);
+  /* scores tree against trips, removing the brackets it matches */
   void precisionRecall( InputTree* tree, ParseStats& parseStats );
+  /* sets gold to the sorted brackets of gold tree tree */
+  void goldBrackets(InputTree* tree, Brackets& gold);
+  /* adds the scores of tree against gold brackets gold */
+  void score(const Brackets& gold, InputTree* tree, ParseStats& parseStats);
+  /* the number of brackets gold and test (both sorted) have in common,
+     counting repeated brackets as often as both have them */
+  static int numMatched(const Brackets& gold, const Brackets& test,
+			Brackets* unmatched = NULL);
   bool scorePunctuation( const ECString trmString );
-  multiset<int> trips;
-  int equivPos[401];
-
+  Brackets trips;
+  vector<int> equivPos;
+ private:
+  Bracket bracket(InputTree* tree, const ECString& trm);
+  void addGold(InputTree* tree, Brackets& gold);
+  int addGuessed(InputTree* tree, Brackets& test);
 };
 
 #endif /* ! SCORET_H */
@@ -36,6 +36,7 @@
 #include "MeChart.h"
 #include "Params.h"
 #include "ParseStats.h"
+#include "ParserModel.h"
 #include "ScoreTree.h"
 #include "SentRep.h"
 #include "TimeIt.h"
@@ -85,9 +86,29 @@ class LabeledSpans: public vector<LabeledSpan> {
         bool disrupts(int start, int end);
 };
 
+// counters for the parse cache (see setParseCacheSize())
+class ParseCacheStats {
+    public:
+        size_t hits;
+        size_t misses;
+        size_t entries;
+        size_t capacity;
+};
+
 vector<ScoredTree>* parse(SentRep* sent, ExtPos& tagConstraints,
                           LabeledSpans* spanConstraints);
 vector<ScoredTree>* parse(SentRep* sent);
+vector<ScoredTree>* parse(SentRep* sent, ExtPos& tagConstraints,
+                          int threadId, size_t nBest);
+vector<vector<ScoredTree> >* parseBatch(vector<SentRep*>& sentences,
+                                        int nBest, int numThreads,
+                                        vector<string>* errors = NULL);
+
+void setParseCacheSize(size_t maxEntries);
+ParseCacheStats getParseCacheStats();
+void clearParseCache();
+void saveParseCache(string filename);
+void loadParseCache(string filename);
 
 ParseStats* getParseStats(InputTree* proposed, InputTree* gold);
 
@@ -95,12 +116,15 @@ double fscore(InputTree* proposed, InputTree* gold);
 
 double treeLogProb(InputTree* tree);
 
+ParserModel* loadModel(string modelPath);
+void useModel(ParserModel* model);
+void releaseModel();
 void loadTermsOnly(string modelPath);
 void loadHeadInfoOnly(string modelPath);
 
 void setOptions(string language, bool caseInsensitive, int nBest,
         bool smallCorpus, double overparsing, int debug,
-        float smoothPosAmount);
+        float smoothPosAmount, int beamWidth = 0, long memLimitMB = 0);
 
 SentRep* tokenize(string text, int expectedTokens);
 SentRep* tokenize(string text);
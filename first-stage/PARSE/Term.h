@@ -85,6 +85,7 @@ public:
     static ECStrings Colons;
     static ECString Language;
 private:
+    friend class ParserModel;
     ECString* namePtr() { return (ECString*)&name_; }
     int    	terminal_p_;
     int		num_;
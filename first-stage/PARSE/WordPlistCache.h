@@ -0,0 +1,70 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.  You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef WORDPLISTCACHE_H
+#define WORDPLISTCACHE_H
+
+#include <pthread.h>
+#include <iostream>
+#include <list>
+#include <map>
+#include <vector>
+#include "ECString.h"
+
+/* the most words (counting each capitalization class separately) the
+   cache holds.  Past this, new (typically unknown) words aren't cached. */
+#define MAXWORDPLISTS 1000000
+
+/* How a word's capitalization bears on its tags (see Bchart::pCapgt()).
+   Capitalization isn't evidence when parsing case insensitively, at the
+   start of a sentence, for one letter words, words in all caps, etc. */
+enum CapClass { CAP_IGNORED, CAP_UPPER, CAP_LOWER, NUMCAPCLASSES };
+
+/*
+ * A WordPlistCache holds the (tag, probability) lists Bchart::wordPlist()
+ * computes, keyed by the lower cased word and its CapClass, which is all
+ * the list depends on when there are no tag or span constraints.  Every
+ * thread parsing with a model shares its cache.  The lists depend on
+ * Bchart::smoothPosAmount as well, so changing that empties the cache.
+ */
+class WordPlistCache
+{
+ public:
+  WordPlistCache();
+  ~WordPlistCache();
+  /* Sets plist to the cached list for word and returns true if there is
+     one (computed with smoothPosAmount). */
+  bool find(const ECString& word, int capClass, float smoothPosAmount,
+	    list<float>& plist);
+  void insert(const ECString& word, int capClass, float smoothPosAmount,
+	      const list<float>& plist);
+  void clear();
+  size_t size();
+  /* Exchanges the cached lists (but not the locks) with other's. */
+  void swap(WordPlistCache& other);
+  /* A header line with the settings the lists depend on,
+       wordPlists smoothPosAmount caseInsensitive language
+     and then one line per word: capClass word n tag1 prob1 ... tagn probn */
+  void write(ostream& os, bool caseInsensitive, const ECString& language);
+  bool read(istream& is, float smoothPosAmount, bool caseInsensitive,
+	    const ECString& language);
+ private:
+  typedef map<ECString, vector<float> > Plists;
+  Plists plists_[NUMCAPCLASSES];
+  float smoothPosAmount_;
+  size_t size_;
+  pthread_rwlock_t lock_;
+};
+
+#endif /* ! WORDPLISTCACHE_H */
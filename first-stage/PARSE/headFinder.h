@@ -24,6 +24,8 @@ void readHeadInfo(ECString& path);
 
 int headPosFromTree(InputTree* tree);
 
-int headPriority(ECString lhsString, ECString rhsString, int ansPriority);
+/* lhsInt and rhsInt are Term::toInt() values, or -1 for labels which
+   are not terms */
+int headPriority(int lhsInt, int rhsInt, int ansPriority);
 
 #endif				/* ! HEADFIND_H */
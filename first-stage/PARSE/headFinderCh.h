@@ -20,8 +20,20 @@
 #include "ECString.h"
 #include "InputTree.h"
 
+/* one of the (compiled) head rules for a lhs in headInfo.txt */
+struct HeadRuleCh
+{
+  bool fromLeft;
+  bool anyHead;         // no heads listed: the first (last) constituent
+  vector<bool> heads;   // indexed by Term::toInt()
+};
+
 void readHeadInfoCh(ECString& path);
 
 int headPosFromTreeCh(InputTree* tree);
 
+/* rhsInts are the Term::toInt() values of the constituents (-1 for
+   labels which are not terms); returns -1 if no head rule applies */
+int headPosFromTermsCh(int lhsInt, const vector<int>& rhsInts);
+
 #endif				/* ! HEADFINDCH_H */
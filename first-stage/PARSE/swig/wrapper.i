@@ -38,6 +38,18 @@ using namespace std;
 %{
     #include "SimpleAPI.C"
     #include "Fusion.h"
+
+#ifdef SWIGPYTHON
+    // releases the GIL for the lifetime of the object (and reacquires
+    // it even if the wrapped call throws)
+    class ReleaseGIL {
+        public:
+            ReleaseGIL() : state(PyEval_SaveThread()) {}
+            ~ReleaseGIL() { PyEval_RestoreThread(state); }
+        private:
+            PyThreadState* state;
+    };
+#endif
 %}
 typedef std::string ECString;
 
@@ -50,7 +62,45 @@ typedef std::string ECString;
     }
 }
 
+#ifdef SWIGPYTHON
+// parseBatch() runs entirely in native worker threads so other Python
+// threads can run while it works
+%exception parseBatch {
+    try {
+        ReleaseGIL releaseGIL;
+        $action
+    } catch (ParserError pe) {
+        SWIG_exception(SWIG_RuntimeError, pe.description.c_str());
+    }
+}
+
+// loadModel() and useModel() can wait for other threads (perhaps in
+// parseBatch(), which needs the GIL back to finish) to finish with
+// another model
+%exception loadModel {
+    try {
+        ReleaseGIL releaseGIL;
+        $action
+    } catch (ParserError pe) {
+        SWIG_exception(SWIG_RuntimeError, pe.description.c_str());
+    }
+}
+
+%exception useModel {
+    try {
+        ReleaseGIL releaseGIL;
+        $action
+    } catch (ParserError pe) {
+        SWIG_exception(SWIG_RuntimeError, pe.description.c_str());
+    }
+}
+#endif
+
+// for native callers which manage their own parser thread ids
+%ignore parse(SentRep*, ExtPos&, int, size_t);
+
 %newobject parse;
+%newobject parseBatch;
 %newobject tokenize;
 %newobject inputTreeFromString;
 %newobject inputTreesFromString;
@@ -81,6 +131,7 @@ namespace std {
 
     %template(StringList) list<string>;
     %template(SentRepList) list<SentRep*>;
+    %template(SentRepVector) vector<SentRep*>;
     %template(InputTrees) list<InputTree*>;
 
     %template(StringVector) vector<string>;
@@ -89,8 +140,9 @@ namespace std {
 }
 
 // bits of header files to wrap -- some of these may not be necessary
-%rename(loadModel) generalInit;
-void generalInit(ECString path);
+
+// opaque handle returned by loadModel()
+class ParserModel;
 
 %feature("python:slot", "sq_length", functype="lenfunc") SentRep::length;
 class SentRep {
@@ -315,4 +367,5 @@ class ParseStats {
 namespace std {
     %template(VectorLabeledSpan) vector<LabeledSpan>;
     %template(VectorScoredTree) vector<ScoredTree>;
+    %template(VectorVectorScoredTree) vector<vector<ScoredTree> >;
 }
@@ -142,7 +142,8 @@ class Feature
     {return lambdas_[wi][featInt-1][bucketInt];}
   static void setLambda(int wi, int featInt, int bucketInt, float val)
     { lambdas_[wi][featInt-1][bucketInt] = val;}
-  static void readLam(int which, ECString tmp, ECString path);
+  static void readLam(int which, ECString tmp, ECString path,
+		      bool newBuckets = true);
   //JT
   static float logFacs[NUMCALCS][MAXNUMFS];
 
@@ -63,6 +63,7 @@ public:
   FTreeMap subtree;
   static int       totParams;
   static int       minCount;
+  static bool      printGs;  // print g values whatever Feat::Usage is
  private:
   static FeatureTree* roots_[15];
   void read(istream& is, FTypeTree* ftt);
@@ -27,4 +27,8 @@ void readHeadInfoEn(ECString& path);
 int headPosFromTree(InputTree* tree);
 int headPosFromTreeEn(InputTree* tree);
 
+/* lhsInt and rhsInt are Term::toInt() values, or -1 for labels which
+   are not terms */
+int headPriority(int lhsInt, int rhsInt, int ansPriority);
+
 #endif				/* ! HEADFIND_H */
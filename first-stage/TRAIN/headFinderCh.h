@@ -24,4 +24,8 @@ void readHeadInfoCh(ECString& path);
 
 int headPosFromTreeCh(InputTree* tree);
 
+/* rhsInts are the Term::toInt() values of the constituents (-1 for
+   labels which are not terms); returns -1 if no head rule applies */
+int headPosFromTermsCh(int lhsInt, const vector<int>& rhsInts);
+
 #endif				/* ! HEADFINDCH_H */
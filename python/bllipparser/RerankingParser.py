@@ -14,11 +14,12 @@
 lower-level (SWIG-generated) CharniakParser and JohnsonReranker modules
 so you don't need to interact with them directly."""
 
+from contextlib import contextmanager
 from os.path import exists, join
 from six import string_types
 from . import CharniakParser as parser
 from . import JohnsonReranker as reranker
-from .Utility import normalize_logprobs
+from .Utility import normalize_logprobs, read_binary_nbest
 
 class Tree(object):
     """Represents a single parse (sub)tree in Penn Treebank format. This
@@ -404,7 +405,7 @@ class Sentence:
 
 class NBestList(object):
     """Represents an n-best list of parses of the same sentence."""
-    def __init__(self, sentrep, parses, sentence_id=None):
+    def __init__(self, sentrep, parses, sentence_id=None, parse_error=None):
         # we keep this around since it's our key to converting our input
         # to the reranker's format (see __str__())
         self._parses = parses
@@ -416,6 +417,8 @@ class NBestList(object):
             scored_parse = ScoredParse(Tree(parse), score, parser_rank=index)
             self.parses.append(scored_parse)
         self.sentence_id = sentence_id
+        # why the parser failed (None unless it did)
+        self.parse_error = parse_error
         # True if we've added reranker scores to our parses
         # (but doesn't necessarily imply that we're sorted by them)
         self._reranked = False
@@ -470,10 +473,15 @@ class NBestList(object):
             return
         if isinstance(reranker_instance, RerankingParser):
             reranker_instance = reranker_instance.reranker_model
-        reranker_input = self.as_reranker_input()
+        reranker_input = self.as_reranker_input(lowercase)
         scores = reranker_instance.scoreNBestList(reranker_input)
-        # this could be more efficient if needed
-        for (score, nbest_list_item) in zip(scores, self.parses):
+        self._set_reranker_scores(scores)
+    def _set_reranker_scores(self, scores):
+        """Adds the reranker's scores (in the parser's original order)
+        to our parses and sorts them by those scores."""
+        # scores are in the parser's original order
+        parses = sorted(self.parses, key=lambda parse: parse.parser_rank)
+        for (score, nbest_list_item) in zip(scores, parses):
             nbest_list_item.reranker_score = score
         self.sort_by_reranker_scores()
         for index, nbest_list_item in enumerate(self.parses):
@@ -529,12 +537,52 @@ class NBestList(object):
                 return '0 %s' % sentence_id
     def as_reranker_input(self, lowercase=True):
         """Convert the n-best list to an internal structure used as input
-        to the reranker. You shouldn't typically need to call this."""
-        return reranker.readNBestList(str(self), lowercase)
+        to the reranker. The parser's trees are converted directly (in
+        the parser's original order) rather than printed and reread.
+        You shouldn't typically need to call this."""
+        sentence_id = self.sentence_id or 'x'
+        return reranker.convertNBestList(self._parses, str(sentence_id),
+                                         lowercase)
+
+    #
+    # readers
+    #
+
+    @classmethod
+    def nbest_lists_from_binary(this_class, data):
+        """Given bytes containing n-best lists in the binary format
+        written by parseIt -b, returns a list of NBestList objects (one
+        for each sentence). A parser model must be loaded since the
+        parses are converted to the parser's trees."""
+        nbest_lists = []
+        for sentence_id, scored_strings in read_binary_nbest(data):
+            parses = parser.VectorScoredTree()
+            for score, tree_string in scored_strings:
+                tree = parser.inputTreeFromString(tree_string)
+                # the NBestList acquires the tree (see __init__)
+                tree.this.disown()
+                parses.append((score, tree))
+            tokens = []
+            if scored_strings:
+                tokens = Tree(scored_strings[0][1]).tokens()
+            sentence = Sentence(parser.SentRep(tokens))
+            nbest_lists.append(this_class(sentence, parses, sentence_id))
+        return nbest_lists
+
+    @classmethod
+    def nbest_lists_from_binary_file(this_class, filename):
+        """Given the path to a file written by parseIt -b, returns a
+        list of NBestList objects (one for each sentence)."""
+        with open(filename, 'rb') as binary_file:
+            return this_class.nbest_lists_from_binary(binary_file.read())
 
 class RerankingParser:
     """Wraps the Charniak parser and Johnson reranker into a single
-    object. Note that RerankingParser is not thread safe."""
+    object. Each RerankingParser can load its own parsing model
+    (e.g., for different domains or languages). Only one parsing model
+    is active in the process at a time, so parsing with one model
+    waits while another thread is parsing with a different one. Note
+    that a single RerankingParser is not thread safe."""
     _parser_model_loaded = False
     _parser_terms_loaded = False
     _parser_heads_loaded = False
@@ -545,6 +593,7 @@ class RerankingParser:
         classmethod which will take care of calling both of these
         for you."""
         self.parser_model_dir = None
+        self._parser_model = None
         self.parser_options = {}
         self.reranker_model = None
         self.unified_model_dir = None
@@ -562,9 +611,13 @@ class RerankingParser:
                           heads_only=False, **parser_options):
         """Load the parsing model from model_dir and set parsing
         options. In general, the default options should suffice but see
-        the set_parser_options() method for details. Note that the parser
-        does not allow loading multiple models within the same process
-        (calling this function twice will raise a RuntimeError).
+        the set_parser_options() method for details. Each RerankingParser
+        can load one parsing model (calling this function twice will
+        raise a RuntimeError) but different RerankingParsers in the same
+        process can load different models. Only one model is active in
+        the process at a time, so parses with different models wait for
+        each other (RerankingParsers which load the same model with the
+        same language share it and don't wait).
 
         If terms_only is True, we will not load the full parsing model,
         just part of speech tag information (intended for tools which
@@ -572,7 +625,7 @@ class RerankingParser:
         we will only load head finding information (for things like
         Tree.dependencies(). If both are set to True, both of these will
         be loaded but the full parsing model will not."""
-        if RerankingParser._parser_model_loaded:
+        if self._parser_model:
             raise RuntimeError('Parser is already loaded and can only '
                                'be loaded once.')
         self._check_path_or_error(model_dir, 'Parser model directory')
@@ -581,7 +634,7 @@ class RerankingParser:
             RerankingParser._parser_heads_loaded = True
             RerankingParser._parser_terms_loaded = True
             self.parser_model_dir = model_dir
-            parser.loadModel(model_dir)
+            self._parser_model = parser.loadModel(model_dir)
             self.set_parser_options(**parser_options)
         else:
             if terms_only:
@@ -610,7 +663,8 @@ class RerankingParser:
         the n-best list, if False the reranker will not be used. rerank
         can also be set to 'auto' which will only rerank if a reranker
         model is loaded. If there are no parses or an error occurs,
-        this will return an empty NBestList."""
+        this will return an empty NBestList (with the reason in its
+        parse_error attribute)."""
         rerank = self.check_models_loaded_or_error(rerank)
 
         sentence = Sentence(sentence)
@@ -621,15 +675,73 @@ class RerankingParser:
                              "under %s)" %
                              (len(sentence), parser.max_sentence_length - 1))
 
-        try:
-            parses = parser.parse(sentence.sentrep)
-        except RuntimeError:
-            parses = []
-        nbest_list = NBestList(sentence, parses, sentence_id)
+        parse_error = None
+        with self._using_parser_model():
+            try:
+                parses = parser.parse(sentence.sentrep)
+            except RuntimeError as e:
+                parses = []
+                parse_error = str(e)
+        nbest_list = NBestList(sentence, parses, sentence_id, parse_error)
         if rerank:
             nbest_list.rerank(self)
         return nbest_list
 
+    def parse_batch(self, sentences, nbest=None, rerank='auto', threads=1,
+                    sentence_ids=None):
+        """Parse a sequence of sentences and return a list of NBestList
+        objects (one per sentence, in the same order). Each sentence
+        can be a string or a sequence of tokens as in parse(). Parsing
+        happens on threads native worker threads and the GIL is released
+        while they run, so other Python threads can keep working. nbest
+        defaults to the nbest parser option. The rerank flag is the same
+        as in parse(); once the whole batch has been parsed, the n-best
+        lists are reranked on threads native threads as well (also
+        without the GIL). parse() calls made from other threads wait
+        while a batch is being parsed. Sentences which fail to parse
+        result in empty NBestLists with the reason in their parse_error
+        attribute."""
+        rerank = self.check_models_loaded_or_error(rerank)
+        if nbest is None:
+            nbest = self.parser_options.get('nbest', 50)
+        if threads < 1:
+            raise ValueError("threads must be at least 1 (got %r)" % threads)
+
+        sentences = [Sentence(sentence) for sentence in sentences]
+        for sentence in sentences:
+            if len(sentence) >= parser.max_sentence_length - 1:
+                raise ValueError("Sentence is too long (%s tokens, must be "
+                                 "under %s)" %
+                                 (len(sentence),
+                                  parser.max_sentence_length - 1))
+        if sentence_ids is None:
+            sentence_ids = [None] * len(sentences)
+        elif len(sentence_ids) != len(sentences):
+            raise ValueError("Need one sentence_id per sentence "
+                             "(%d sentences, %d ids)" %
+                             (len(sentences), len(sentence_ids)))
+
+        sentreps = parser.SentRepVector([s.sentrep for s in sentences])
+        parse_errors = parser.StringVector()
+        with self._using_parser_model():
+            batch = parser.parseBatch(sentreps, int(nbest), int(threads),
+                                      parse_errors)
+        if rerank:
+            batch_scores = self.reranker_model.scoreBatch(batch, True,
+                                                          int(threads))
+        nbest_lists = []
+        for index, (sentence, parses, sentence_id, parse_error) in \
+                enumerate(zip(sentences, batch, sentence_ids, parse_errors)):
+            nbest_list = NBestList(sentence, parses, sentence_id,
+                                   parse_error or None)
+            if rerank:
+                if nbest_list.parses:
+                    nbest_list._set_reranker_scores(batch_scores[index])
+                else:
+                    nbest_list._reranked = True
+            nbest_lists.append(nbest_list)
+        return nbest_lists
+
     def parse_tagged(self, tokens, possible_tags, rerank='auto',
                      sentence_id=None):
         """Parse some pre-tagged, pre-tokenized text. tokens must be a
@@ -687,24 +799,26 @@ class RerankingParser:
         else:
             span_constraints = None
 
-        possible_tags = possible_tags or {}
-        ext_pos = self._possible_tags_to_ext_pos(tokens, possible_tags)
-        sentence = Sentence(tokens)
-        try:
-            parses = parser.parse(sentence.sentrep, ext_pos, span_constraints)
-            if constraints and not parses:
-                raise RuntimeError("Reparsing with relaxed constraints")
-        except RuntimeError:
-            if span_constraints:
-                # we should relax them and retry
-                span_constraints.minSizeForParsing = 2
-                try:
-                    parses = parser.parse(sentence.sentrep, ext_pos,
-                                          span_constraints)
-                except RuntimeError:
+        with self._using_parser_model():
+            possible_tags = possible_tags or {}
+            ext_pos = self._possible_tags_to_ext_pos(tokens, possible_tags)
+            sentence = Sentence(tokens)
+            try:
+                parses = parser.parse(sentence.sentrep, ext_pos,
+                                      span_constraints)
+                if constraints and not parses:
+                    raise RuntimeError("Reparsing with relaxed constraints")
+            except RuntimeError:
+                if span_constraints:
+                    # we should relax them and retry
+                    span_constraints.minSizeForParsing = 2
+                    try:
+                        parses = parser.parse(sentence.sentrep, ext_pos,
+                                              span_constraints)
+                    except RuntimeError:
+                        parses = []
+                else:
                     parses = []
-            else:
-                parses = []
         nbest_list = NBestList(sentence, parses, sentence_id)
         if rerank:
             nbest_list.rerank(self)
@@ -743,7 +857,8 @@ class RerankingParser:
         elif not allow_failures:
             sentence = Sentence(text_or_tokens)
             tokens = sentence.tokens()
-            tags = sentence.independent_tags()
+            with self._using_parser_model():
+                tags = sentence.independent_tags()
             tokens_and_tags = list(zip(tokens, tags))
         else:
             raise ValueError('Parse failed while tagging: %r' % text_or_tokens)
@@ -782,7 +897,7 @@ class RerankingParser:
         if model(s) are not loaded. Also returns whether the reranker
         should be used (essentially resolves the value of rerank if
         rerank='auto')."""
-        if not self._parser_model_loaded:
+        if not self._parser_model:
             raise ValueError("Parser model has not been loaded.")
         if rerank is True and not self.reranker_model:
             raise ValueError("Reranker model has not been loaded.")
@@ -803,7 +918,7 @@ class RerankingParser:
 
     def set_parser_options(self, language='En', case_insensitive=False,
                            nbest=50, small_corpus=True, overparsing=21,
-                           debug=0, smooth_pos=0):
+                           debug=0, smooth_pos=0, beam_width=0, mem_limit=0):
         """Set options for the parser. Note that this is called
         automatically by load_parser_model() so you should only need to
         call this to update the parsing options. The method returns a
@@ -822,13 +937,24 @@ class RerankingParser:
         than 0 will cause the parser to print debug messages (surprising,
         no?). Setting smooth_pos to a number higher than 0 will cause the
         parser to assign that value as the probability of seeing a known
-        word in a new part-of-speech (one never seen in training)."""
-        if not RerankingParser._parser_model_loaded:
+        word in a new part-of-speech (one never seen in training).
+        Setting beam_width to a positive number makes the parser search
+        the chart span by span, taking at most that many edges off the
+        agenda for each span, so its time depends only on the sentence
+        length (but it is less accurate than the default search).
+        mem_limit caps the memory each parse may use, in megabytes. A
+        parse which reaches it returns the parses found so far, or fails
+        if there are none. Both are off (0) by default."""
+        if not self._parser_model:
             raise RuntimeError('Parser must already be loaded (call '
                                'load_parser_model() first)')
+        if beam_width < 0:
+            raise ValueError("beam_width must be non-negative (got %r)" %
+                             beam_width)
+        if mem_limit < 0:
+            raise ValueError("mem_limit must be non-negative (got %r)" %
+                             mem_limit)
 
-        parser.setOptions(language, case_insensitive, nbest, small_corpus,
-                          overparsing, debug, smooth_pos)
         self.parser_options = {
             'language': language,
             'case_insensitive': case_insensitive,
@@ -836,10 +962,53 @@ class RerankingParser:
             'small_corpus': small_corpus,
             'overparsing': overparsing,
             'debug': debug,
-            'smooth_pos': smooth_pos
+            'smooth_pos': smooth_pos,
+            'beam_width': beam_width,
+            'mem_limit': mem_limit
         }
+        # apply them now as well for code which uses whichever model is
+        # active (e.g., Tree.log_prob())
+        with self._using_parser_model():
+            pass
         return self.parser_options
 
+    def set_parse_cache_size(self, max_entries):
+        """Cache the n-best lists of up to max_entries distinct
+        sentences, so parsing a sentence again (with the same model,
+        options and constraints) doesn't run the parser. The least
+        recently used lists are dropped when the cache is full. The
+        cache is shared by all RerankingParsers in the process and is
+        off (max_entries=0) by default. Reranking is not cached."""
+        if max_entries < 0:
+            raise ValueError("max_entries must be non-negative (got %r)" %
+                             max_entries)
+        parser.setParseCacheSize(int(max_entries))
+
+    def parse_cache_stats(self):
+        """Returns a dictionary with the number of hits and misses in
+        the parse cache, the number of n-best lists it holds (entries)
+        and its capacity (see set_parse_cache_size())."""
+        stats = parser.getParseCacheStats()
+        return dict(hits=stats.hits, misses=stats.misses,
+                    entries=stats.entries, capacity=stats.capacity)
+
+    @contextmanager
+    def _using_parser_model(self):
+        """Makes this RerankingParser's parsing model (and options)
+        the active ones while the block runs."""
+        parser.useModel(self._parser_model)
+        try:
+            options = self.parser_options
+            parser.setOptions(options['language'],
+                              options['case_insensitive'], options['nbest'],
+                              options['small_corpus'],
+                              options['overparsing'], options['debug'],
+                              options['smooth_pos'], options['beam_width'],
+                              options['mem_limit'])
+            yield
+        finally:
+            parser.releaseModel()
+
     @classmethod
     def from_unified_model_dir(this_class, model_dir, parsing_options=None,
                                reranker_options=None, parser_only=False):
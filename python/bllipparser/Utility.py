@@ -12,6 +12,7 @@
 
 import math
 import importlib
+import struct
 
 def import_maybe(module_name):
     "Import a module and return it if available, otherwise returns None."
@@ -48,3 +49,56 @@ def normalize_logprobs(logprobs, exponent=1):
                  for logprob in logprobs]
     z = sum(exp_diffs)
     return [exp_diff / z for exp_diff in exp_diffs]
+
+BINARY_NBEST_MAGIC = 0x02
+BINARY_NBEST_VERSION = 1
+
+def read_binary_nbest(data):
+    """Decodes n-best lists in the binary format written by parseIt -b
+    (see first-stage/PARSE/BinaryNBest.h). data is a bytes object
+    holding any number of sentences. Yields (sentence_id, parses)
+    for each sentence where parses is a list of (log prob, Penn
+    Treebank string) pairs in the parser's order."""
+    data = bytearray(data)
+    pos = [0]
+    def read_uint():
+        n = shift = 0
+        while True:
+            byte = data[pos[0]]
+            pos[0] += 1
+            n |= (byte & 0x7f) << shift
+            if not byte & 0x80:
+                return n
+            shift += 7
+    def read_string():
+        size = read_uint()
+        start = pos[0]
+        pos[0] += size
+        return bytes(data[start:pos[0]]).decode('utf-8')
+
+    while pos[0] < len(data):
+        magic, version = data[pos[0]], data[pos[0] + 1]
+        if magic != BINARY_NBEST_MAGIC or version != BINARY_NBEST_VERSION:
+            raise ValueError("Not a binary n-best list (version %d) at "
+                             "byte %d" % (BINARY_NBEST_VERSION, pos[0]))
+        pos[0] += 2
+        sentence_id = read_string()
+        strings = [read_string() for index in range(read_uint())]
+        # children always come before their parents
+        nodes = []
+        for index in range(read_uint()):
+            label = read_uint()
+            if label & 1:
+                word = strings[read_uint()]
+                nodes.append('(%s %s)' % (strings[label >> 1], word))
+            else:
+                children = [nodes[read_uint()]
+                            for child in range(read_uint())]
+                nodes.append('(%s %s)' % (strings[label >> 1],
+                                          ' '.join(children)))
+        parses = []
+        for index in range(read_uint()):
+            logprob, = struct.unpack('<d', bytes(data[pos[0]:pos[0] + 8]))
+            pos[0] += 8
+            parses.append((logprob, nodes[read_uint()]))
+        yield sentence_id, parses
@@ -175,7 +175,7 @@ will change the size of the n-best list and pick the defaults for all
 other options. It returns a dictionary of the current options::
 
     >>> rrp.set_parser_options(nbest=10)
-    {'language': 'En', 'case_insensitive': False, 'debug': 0, 'small_corpus': True, 'overparsing': 21, 'smooth_pos': 0, 'nbest': 10}
+    {'language': 'En', 'case_insensitive': False, 'debug': 0, 'small_corpus': True, 'overparsing': 21, 'smooth_pos': 0, 'nbest': 10, 'beam_width': 0, 'mem_limit': 0}
     >>> nbest_list = rrp.parse('The list is smaller now.', rerank=False)
     >>> len(nbest_list)
     10
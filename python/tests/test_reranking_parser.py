@@ -12,8 +12,10 @@
 
 from __future__ import print_function
 
+import threading
 import unittest
 from bllipparser import Sentence, tokenize, RerankingParser, Tree
+from bllipparser import JohnsonReranker
 from bllipparser.RerankingParser import (NBestList, ScoredParse,
                                          get_unified_model_parameters)
 
@@ -549,7 +551,8 @@ class RerankingParserTests(unittest.TestCase):
         self.assertEqual(rrp.set_parser_options(nbest=10),
                          dict(case_insensitive=False, debug=0,
                               language='En', nbest=10, overparsing=21,
-                              small_corpus=True, smooth_pos=0))
+                              small_corpus=True, smooth_pos=0,
+                              beam_width=0, mem_limit=0))
 
         nbest_list = rrp.parse('The list is smaller now.', rerank=False)
         self.assertEqual(len(nbest_list), 10)
@@ -696,7 +699,8 @@ class RerankingParserTests(unittest.TestCase):
         self.assertEqual(rrp.set_parser_options(nbest=50),
                          dict(case_insensitive=False, debug=0,
                               language='En', nbest=50, overparsing=21,
-                              small_corpus=True, smooth_pos=0))
+                              small_corpus=True, smooth_pos=0,
+                              beam_width=0, mem_limit=0))
 
         # test one actually complex sentence with fusion options
         complex_sentence = 'Economists are divided as to how much '\
@@ -827,8 +831,97 @@ class RerankingParserTests(unittest.TestCase):
         nbest_list_fail = rrp.parse('# ! ? : -', rerank=False)
         self.assertEqual(len(nbest_list_fail), 0)
         self.assertEqual(str(nbest_list_fail), '0 x')
+        self.assertEqual(nbest_list_fail.parse_error,
+                         'Parse failed: !topS')
         nbest_list_fail = rrp.parse_constrained('# ! ? : -'.split(), {})
         self.assertEqual(len(nbest_list_fail), 0)
+
+        # batch parsing should match parsing one sentence at a time
+        batch_sentences = ['This is a sentence.', '# ! ? : -',
+                           ['This', 'is', 'a', 'pretokenized', 'sentence',
+                            '.'], 'This is a sentence.']
+        expected = [str(rrp.parse(sentence)) for sentence in batch_sentences
+                    if sentence != '# ! ? : -']
+        for threads in (1, 3):
+            nbest_lists = rrp.parse_batch(batch_sentences, threads=threads)
+            self.assertEqual(len(nbest_lists), 4)
+            self.assertEqual(str(nbest_lists[0]), expected[0])
+            self.assertEqual(len(nbest_lists[1]), 0)
+            self.assertEqual(nbest_lists[1].parse_error,
+                             'Parse failed: !topS')
+            self.assertEqual(nbest_lists[0].parse_error, None)
+            self.assertEqual(str(nbest_lists[2]), expected[1])
+            self.assertEqual(str(nbest_lists[3]), expected[2])
+        nbest_lists = rrp.parse_batch(batch_sentences[:1], nbest=2,
+                                      rerank=False, sentence_ids=['a'])
+        self.assertEqual(len(nbest_lists[0]), 2)
+        self.assertEqual(nbest_lists[0].sentence_id, 'a')
+        self.assertEqual(rrp.parse_batch([]), [])
+        self.assertRaises(ValueError, rrp.parse_batch, batch_sentences,
+                          threads=0)
+        self.assertRaises(ValueError, rrp.parse_batch, batch_sentences,
+                          sentence_ids=['too', 'few'])
+
+        # reranking an already reranked (and so resorted) list is stable
+        nbest_list = rrp.parse('This is a sentence.')
+        reranked = [(parse.parser_rank, parse.reranker_score)
+                    for parse in nbest_list]
+        nbest_list.rerank(rrp)
+        self.assertEqual([(parse.parser_rank, parse.reranker_score)
+                          for parse in nbest_list], reranked)
+
+        # the parser's n-best lists convert to reranker input directly,
+        # scoring the same as their text form (up to its rounding)
+        nbest_list = rrp.parse('This is a sentence.', rerank=False)
+        converted = nbest_list.as_reranker_input()
+        self.assertEqual(len(converted), len(nbest_list))
+        reread = JohnsonReranker.readNBestList(str(nbest_list), True)
+        self.assertEqual(len(reread), len(nbest_list))
+        for score1, score2 in zip(rrp.reranker_model.scoreNBestList(converted),
+                                  rrp.reranker_model.scoreNBestList(reread)):
+            self.assertAlmostEqual(score1, score2, places=4)
+
+        # repeated sentences come from the parse cache when it's on
+        rrp.set_parse_cache_size(2)
+        uncached = str(rrp.parse('This is a sentence.'))
+        self.assertEqual(str(rrp.parse('This is a sentence.')), uncached)
+        self.assertEqual(rrp.parse_cache_stats(),
+                         dict(hits=1, misses=1, entries=1, capacity=2))
+        self.assertEqual(len(rrp.parse('# ! ? : -')), 0)
+        self.assertEqual(len(rrp.parse('# ! ? : -')), 0)
+        self.assertEqual(rrp.parse_cache_stats()['hits'], 2)
+        rrp.set_parse_cache_size(0)
+        self.assertEqual(rrp.parse_cache_stats()['entries'], 0)
+        self.assertRaises(ValueError, rrp.set_parse_cache_size, -1)
+
+        # a second parser loading the same model shares the loaded copy
+        # and gives the same results when the two are interleaved
+        rrp2 = RerankingParser()
+        rrp2.load_parser_model('first-stage/DATA/EN')
+        self.assertRaises(RuntimeError, rrp2.load_parser_model,
+                          'first-stage/DATA/EN')
+        for sentence in batch_sentences:
+            self.assertEqual(str(rrp2.parse(sentence)),
+                             str(rrp.parse(sentence, rerank=False)))
+        self.assertEqual(rrp.tag('This is a sentence.'),
+                         rrp2.tag('This is a sentence.'))
+
+        # loading a model while a batch is parsing waits for the batch to
+        # finish (rather than deadlocking on the GIL)
+        batch_results = []
+        batch = threading.Thread(target=lambda: batch_results.append(
+            rrp.parse_batch(batch_sentences * 10, rerank=False, threads=2)))
+        rrp3 = RerankingParser()
+        loader = threading.Thread(target=rrp3.load_parser_model,
+                                  args=('first-stage/DATA/EN',))
+        batch.start()
+        loader.start()
+        for thread in (batch, loader):
+            thread.join(600)
+            self.assertFalse(thread.is_alive())
+        self.assertEqual(len(batch_results[0]), 40)
+        self.assertEqual(str(rrp3.parse(batch_sentences[0])),
+                         str(rrp.parse(batch_sentences[0], rerank=False)))
     def test_3_tree_funcs(self):
         # these are here and not in test_tree since they require a parsing
         # model to have been loaded
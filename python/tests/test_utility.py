@@ -12,8 +12,9 @@
 
 from __future__ import print_function
 
+import struct
 import unittest
-from bllipparser.Utility import import_maybe
+from bllipparser.Utility import import_maybe, read_binary_nbest
 
 class UtilityTests(unittest.TestCase):
     def test_import_maybe(self):
@@ -22,3 +23,23 @@ class UtilityTests(unittest.TestCase):
         self.assertEqual(time, time_module)
         nothing = import_maybe('adummypackagenamewhichbetternotexist')
         self.assertEqual(nothing, None)
+
+    def test_read_binary_nbest(self):
+        def string(s):
+            return bytearray([len(s)]) + bytearray(s.encode('ascii'))
+        data = bytearray([2, 1]) + string('7')
+        data += bytearray([5]) + string('NNS') + string('dogs') + \
+            string('NP') + string('S1') + string('NN')
+        # (NNS dogs), (NP 0), (S1 1), (NN dogs), (S1 3)
+        data += bytearray([5, 1, 1, 4, 1, 0, 6, 1, 1, 9, 1, 6, 1, 3])
+        data += bytearray([2]) + bytearray(struct.pack('<d', -10.5)) + \
+            bytearray([2]) + bytearray(struct.pack('<d', -12.25)) + \
+            bytearray([4])
+        expected = ('7', [(-10.5, '(S1 (NP (NNS dogs)))'),
+                          (-12.25, '(S1 (NN dogs))')])
+        self.assertEqual(list(read_binary_nbest(bytes(data))), [expected])
+        self.assertEqual(list(read_binary_nbest(bytes(data * 2))),
+                         [expected, expected])
+        self.assertEqual(list(read_binary_nbest(b'')), [])
+        self.assertRaises(ValueError, list,
+                          read_binary_nbest(b'1\tx\n'))
@@ -14,10 +14,19 @@
 //
 // Mark Johnson 16th August 2003, modified 25th November 2009
 
+static const char usage[] =
+"Usage: main [-j nthreads] [-b blocksize] parses-cmd gold-cmd\n"
+"\n"
+" -j nthreads : read and score the parses on nthreads threads\n"
+"               (default: as many as OpenMP allows)\n"
+" -b blocksize : read blocksize sentences at a time (default 1024).\n";
+
 #include "custom_allocator.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <getopt.h>
 #include <iostream>
 #include <utility>
 #include <vector>
@@ -28,22 +37,30 @@
 #include "tree.h"
 #include "utility.h"
 
+// beam_sizer_type{} collects the oracle statistics for the sentences it
+// is called on.  One is kept per thread, and they are merged with +=.
+//
 struct beam_sizer_type {
   size_t nsentences;
   size_t nparses;
+  size_t nparsed;
+  size_t n_exact_match;
   precrec_type first_prs, maxprob_prs, best_prs;
   std::vector<precrec_type> precrecs;
   std::vector<size_t> nparses_counts;
-  std::map<size_t,size_t> bestparseindex_count;
-  std::map<Float,size_t> logrelprobbest_count;
-  std::map<Float,size_t> logcondprobbest_count;
+  typedef std::map<size_t,size_t> S_C;
+  typedef std::map<Float,size_t> F_C;
+  S_C bestparseindex_count;
+  F_C logrelprobbest_count;
+  F_C logcondprobbest_count;
   std::vector<precrec_type> lrpt_prs;
   std::vector<size_t> lrpt_count;
   std::vector<precrec_type> lcpt_prs;
   std::vector<size_t> lcpt_count;
 
   beam_sizer_type(size_t n=100) 
-    : nsentences(0), nparses(0), precrecs(n), nparses_counts(n), 
+    : nsentences(0), nparses(0), nparsed(0), n_exact_match(0), 
+      precrecs(n), nparses_counts(n), 
       lrpt_prs(51), lrpt_count(51), lcpt_prs(51), lcpt_count(51) { }
 
   void operator()(sp_sentence_type& s) { 
@@ -54,6 +71,8 @@ struct beam_sizer_type {
     if (s.parses.empty())
       return;
 
+    ++nparsed;
+
     typedef std::pair<Float,precrec_type> FPR;
     std::vector<FPR> fprs;
     fprs.reserve(s.parses.size()); 
@@ -105,6 +124,8 @@ struct beam_sizer_type {
     }
 
     best_prs += best;
+    if (best.ncommon == best.ngold && best.ncommon == best.ntest)
+      ++n_exact_match;
     ++bestparseindex_count[bestparseindex];
     ++logrelprobbest_count[bestlogprob-logmaxprob];  // logrelprob of best parse
     ++logcondprobbest_count[bestlogcondprob];  // logcondprob of best parse
@@ -144,6 +165,36 @@ struct beam_sizer_type {
     }
   }  // beam_sizer_type::operator()
 
+  //! operator+= adds the statistics collected by b to this one's
+  //
+  beam_sizer_type& operator+= (const beam_sizer_type& b) {
+    assert(precrecs.size() == b.precrecs.size());
+    nsentences += b.nsentences;
+    nparses += b.nparses;
+    nparsed += b.nparsed;
+    n_exact_match += b.n_exact_match;
+    first_prs += b.first_prs;
+    maxprob_prs += b.maxprob_prs;
+    best_prs += b.best_prs;
+    for (size_t i = 0; i < precrecs.size(); ++i) {
+      precrecs[i] += b.precrecs[i];
+      nparses_counts[i] += b.nparses_counts[i];
+    }
+    cforeach (S_C, it, b.bestparseindex_count)
+      bestparseindex_count[it->first] += it->second;
+    cforeach (F_C, it, b.logrelprobbest_count)
+      logrelprobbest_count[it->first] += it->second;
+    cforeach (F_C, it, b.logcondprobbest_count)
+      logcondprobbest_count[it->first] += it->second;
+    for (size_t j = 0; j < lrpt_prs.size(); ++j) {
+      lrpt_prs[j] += b.lrpt_prs[j];
+      lrpt_count[j] += b.lrpt_count[j];
+      lcpt_prs[j] += b.lcpt_prs[j];
+      lcpt_count[j] += b.lcpt_count[j];
+    }
+    return *this;
+  }  // beam_sizer_type::operator+=
+
   static inline Float index_lcpt(size_t index) { return index/-4.0; }
 
   static inline Float index_lrpt(size_t index) { return index/-4.0; }
@@ -151,12 +202,48 @@ struct beam_sizer_type {
 
 int main(int argc, char** argv)
 {
-  assert(argc == 3);
-  beam_sizer_type beam_sizer;
-  size_t nsentences = sp_corpus_type::map_sentences_cmd(argv[1], argv[2], beam_sizer);
-  std::cout << "# Read " << nsentences << " sentences from " << argv[1] << " and " << argv[2] << std::endl;
+  std::ios::sync_with_stdio(false);
+
+#ifdef _OPENMP
+  int nthreads = omp_get_max_threads();
+#else
+  int nthreads = 1;
+#endif
+  size_t blocksize = 1024;
+
+  int c;
+  while ((c = getopt(argc, argv, "j:b:")) != -1 )
+    switch (c) {
+    case 'j':
+      nthreads = atoi(optarg);
+      break;
+    case 'b':
+      blocksize = atoi(optarg);
+      break;
+    default:
+      std::cerr << usage << std::endl;
+      exit(EXIT_FAILURE);
+      break;
+    }
+
+  if (argc != optind+2 || nthreads < 1 || blocksize < 1) {
+    std::cerr << usage << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<beam_sizer_type> beam_sizers(nthreads);
+  size_t nsentences = 
+    sp_corpus_type::map_sentences_parallel_cmd(argv[optind], argv[optind+1], 
+					       beam_sizers, false, blocksize);
+  beam_sizer_type& beam_sizer = beam_sizers[0];
+  for (int t = 1; t < nthreads; ++t)
+    beam_sizer += beam_sizers[t];
+
+  std::cout << "# Read " << nsentences << " sentences from " << argv[optind] << " and " << argv[optind+1] << std::endl;
 
   std::cout << "# Oracle " << beam_sizer.best_prs << std::endl;
+  std::cout << "# Oracle exact match " << beam_sizer.n_exact_match << '/' << beam_sizer.nparsed
+	    << " = " << double(beam_sizer.n_exact_match)/double(beam_sizer.nparsed) << std::endl;
   std::cout << "# Maxprob parse " << beam_sizer.maxprob_prs << std::endl;
   std::cout << "# First parse " << beam_sizer.first_prs << std::endl;
 
@@ -19,6 +19,7 @@
 #ifndef SP_DATA_H
 #define SP_DATA_H
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <cmath>
@@ -29,6 +30,10 @@
 #include <string>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "popen.h"
 #include "sptree.h"
 #include "tree.h"
@@ -48,6 +53,119 @@ tree_node<label_type>* strip_function_tags(tree_node<label_type>* tp) {
   return tp;
 }
 
+// binary_nbest_type{} holds the label, word and node tables of one
+// sentence in the binary n-best format written by parseIt -b (see
+// first-stage/PARSE/BinaryNBest.h for the format).  Nodes are shared
+// between parses in the file, but node_tree() builds separate trees.
+//
+struct binary_nbest_type {
+  static const char magic = 0x02;
+  static const char version = 1;
+
+  struct node_type {
+    unsigned label;
+    unsigned word;   // only used by preterminals
+    bool preterminal;
+    std::vector<unsigned> children;
+  };
+
+  std::vector<std::string> strings;
+  std::vector<node_type> nodes;
+
+  static bool read_uint(std::istream& is, unsigned& n) {
+    n = 0;
+    char c;
+    for (unsigned shift = 0; shift < 32 && is.get(c); shift += 7) {
+      n |= (unsigned(c) & 0x7f) << shift;
+      if (!(c & 0x80))
+	return true;
+    }
+    is.setstate(std::ios::failbit);
+    return false;
+  }  // binary_nbest_type::read_uint()
+
+  static bool read_string(std::istream& is, std::string& s) {
+    unsigned size;
+    if (!read_uint(is, size))
+      return false;
+    s.resize(size);
+    return size == 0 || is.read(&s[0], size);
+  }  // binary_nbest_type::read_string()
+
+  static bool read_double(std::istream& is, double& d) {
+    unsigned char bytes[8];
+    if (!is.read(reinterpret_cast<char*>(bytes), 8))
+      return false;
+    unsigned long long bits = 0;
+    for (int i = 7; i >= 0; --i)
+      bits = (bits << 8) | bytes[i];
+    assert(sizeof(d) == sizeof(bits));
+    std::memcpy(&d, &bits, sizeof(d));
+    return true;
+  }  // binary_nbest_type::read_double()
+
+  //! read() reads the string and node tables (which follow the
+  //! sentence's label)
+  //
+  std::istream& read(std::istream& is) {
+    unsigned nstrings, nnodes;
+    if (!read_uint(is, nstrings))
+      return is;
+    strings.resize(nstrings);
+    for (unsigned i = 0; i < nstrings; ++i)
+      if (!read_string(is, strings[i]))
+	return is;
+    if (!read_uint(is, nnodes))
+      return is;
+    nodes.resize(nnodes);
+    for (unsigned i = 0; i < nnodes; ++i) {
+      node_type& node = nodes[i];
+      unsigned label, n;
+      if (!read_uint(is, label) || !read_uint(is, n))
+	return is;
+      node.label = label >> 1;
+      node.preterminal = label & 1;
+      if (node.preterminal)
+	node.word = n;
+      else {
+	node.children.resize(n);
+	for (unsigned j = 0; j < n; ++j)
+	  if (!read_uint(is, node.children[j]))
+	    return is;
+      }
+      // labels and words are in the string table and children come first
+      bool ok = node.label < nstrings 
+	&& (!node.preterminal || node.word < nstrings);
+      for (unsigned j = 0; j < node.children.size(); ++j)
+	ok = ok && node.children[j] < i;
+      if (!ok) {
+	std::cerr << HERE << "\n## Error: bad node in binary n-best list." << std::endl;
+	is.setstate(std::ios::failbit);
+	return is;
+      }
+    }
+    return is;
+  }  // binary_nbest_type::read()
+
+  //! node_tree() returns a new tree for node i, the same tree as reading
+  //! its text form would produce
+  //
+  tree* node_tree(unsigned i) const {
+    const node_type& node = nodes[i];
+    if (node.preterminal)
+      return new tree(tree::label_type::cat_type(strings[node.label]),
+		      new tree(tree::label_type::cat_type(strings[node.word])));
+    tree* children = NULL;
+    for (size_t j = node.children.size(); j > 0; --j) {
+      tree* child = node_tree(node.children[j-1]);
+      child->next = children;
+      children = child;
+    }
+    return new tree(tree::label_type::cat_type(strings[node.label]), children);
+  }  // binary_nbest_type::node_tree()
+
+};  // binary_nbest_type{}
+
 // parse_type{} holds the data for a single parse.  It has a pointer
 // to the parse tree, but someone else must free it when it is deleted!
 //
@@ -107,6 +225,30 @@ struct sp_parse_type {
     return is;
   }  // read_nbest()
 
+  //! read() reads a parse of a binary n-best list (its log probability
+  //! and root node) whose tables are in nbest
+  //
+  std::istream& read(std::istream& is, const binary_nbest_type& nbest,
+		     bool downcase_flag=false) {
+    double logprob0;
+    unsigned root;
+    if (binary_nbest_type::read_double(is, logprob0)
+	&& binary_nbest_type::read_uint(is, root)) {
+      if (root >= nbest.nodes.size()) {
+	std::cerr << HERE << "\n## Error: bad root in binary n-best list." << std::endl;
+	is.setstate(std::ios::failbit);
+	return is;
+      }
+      logprob = logprob0;
+      ASSERT(finite(logprob));
+      parse0 = nbest.node_tree(root);
+      parse0->label.cat = tree::label_type::root();
+      parse = tree_sptree(parse0, downcase_flag);
+      assert(parse != NULL);
+    }
+    return is;
+  }  // sp_parse_type::read()
+
 };  // sp_parse_type{}
 
 
@@ -259,8 +401,9 @@ struct sp_sentence_type {
   //! produced by Eugene Charniak's or Slav Petrov's n-best parser.
   //! It determines which to read by looking at the first character
   //! of the output.  If it begins with a '-' then we assume it is
-  //! produced by Slav's parser, otherwise we assume it is produced
-  //! by Eugene's parser.
+  //! produced by Slav's parser, if it is binary_nbest_type::magic
+  //! it is Eugene's parser's binary format (parseIt -b), otherwise
+  //! we assume it is produced by Eugene's parser.
   //
   std::istream& read(std::istream& is, bool downcase_flag=false) {
     clear();
@@ -276,6 +419,8 @@ struct sp_sentence_type {
 
     is.unget();
     
+    if (c == binary_nbest_type::magic)
+      return read_binary(is, downcase_flag);
     if (c == '-' || c == '0') { // Petrov-style Berkeley parser output
       if (nblanklines == 0) {
 	std::string line;
@@ -326,6 +471,33 @@ struct sp_sentence_type {
     return is;
   }  // sp_sentence_type::read()
 
+  //! read_binary() reads one sentence in the binary n-best format
+  //
+  std::istream& read_binary(std::istream& is, bool downcase_flag=false) {
+    char magic, version;
+    is.get(magic);
+    is.get(version);
+    if (is && version != binary_nbest_type::version) {
+      std::cerr << HERE << "\n## Error: unknown binary n-best format version "
+		<< int(version) << std::endl;
+      is.setstate(std::ios::failbit);
+    }
+    binary_nbest_type nbest;
+    unsigned nparses;
+    if (!binary_nbest_type::read_string(is, label) || !nbest.read(is)
+	|| !binary_nbest_type::read_uint(is, nparses))
+      return is;
+    parses.resize(nparses);
+    for (size_t i = 0; i < nparses; ++i) {
+      parses[i].read(is, nbest, downcase_flag);
+      ASSERT(is);
+      ASSERT(parses[i].parse != NULL);
+    }
+    if (!parses.empty())
+      set_logcondprob();
+    return is;
+  }  // sp_sentence_type::read_binary()
+
   //! read() reads a set of trees from parsestream and the corresponding tree
   //! from goldstream.
   //
@@ -427,6 +599,155 @@ std::ostream& operator<< (std::ostream& os, const sp_sentence_type& s) {
 }
 
 
+// sp_sentence_text{} holds the unparsed text of one sentence's n-best
+// parses and gold tree, as sp_sentence_type::read() would consume it.
+// Splitting the input into sentences is cheap, so
+// sp_corpus_type::map_sentences_parallel() does that on one thread and
+// leaves reading the trees and scoring the parses to the others.
+//
+struct sp_sentence_text {
+  std::string parses;
+  std::string gold;
+
+  //! read_tree() appends the next parenthesized tree in is to s
+  //
+  static bool read_tree(std::istream& is, std::string& s) {
+    char c;
+    if (!(is >> c) || c != '(')
+      return false;
+    s.push_back(' ');
+    int depth = 0;
+    do {
+      s.push_back(c);
+      if (c == '(')
+	++depth;
+      else if (c == ')')
+	--depth;
+    } while (depth > 0 && is.get(c));
+    return depth == 0;
+  }  // sp_sentence_text::read_tree()
+
+  //! read_parses() reads the text of the next set of n-best parses,
+  //! distinguishing Eugene's and Slav's parser output as
+  //! sp_sentence_type::read() does.
+  //
+  bool read_parses(std::istream& is) {
+    parses.clear();
+
+    char c;
+    unsigned nblanklines = 0;
+    while (is.get(c) && isspace(c))
+      if (c == '\n')
+	++nblanklines;
+
+    if (!is)
+      return false;
+
+    is.unget();
+
+    if (c == binary_nbest_type::magic)  // parseIt -b output
+      return copy_binary(is);
+    if (c == '-' || c == '0') { // Petrov-style Berkeley parser output
+      if (nblanklines == 0) {
+	std::string line;
+	while (getline(is, line)) {
+	  if (line.find_first_not_of(" \n\r\t") == std::string::npos)
+	    break;
+	  parses += line;
+	  parses += '\n';
+	}
+	parses += '\n';
+      }
+      else {  // the parser failed on this sentence
+	parses += '\n';
+	parses += c;
+	while (--nblanklines > 0)
+	  is.putback('\n');
+      }
+      return true;
+    }
+    else { // Charniak-style parser output
+      size_t nparses;
+      std::string label, logprob;
+      if (!(is >> nparses >> label))
+	return false;
+      std::ostringstream header;
+      header << nparses << ' ' << label << '\n';
+      parses = header.str();
+      for (size_t i = 0; i < nparses; ++i) {
+	if (!(is >> logprob))
+	  return false;
+	parses += logprob;
+	if (!read_tree(is, parses))
+	  return false;
+	parses += '\n';
+      }
+      return true;
+    }
+  }  // sp_sentence_text::read_parses()
+
+  //! copy_uint() appends the next LEB128 integer in is to parses and
+  //! sets n to its value
+  //
+  bool copy_uint(std::istream& is, unsigned& n) {
+    n = 0;
+    char c;
+    for (unsigned shift = 0; shift < 32 && is.get(c); shift += 7) {
+      parses.push_back(c);
+      n |= (unsigned(c) & 0x7f) << shift;
+      if (!(c & 0x80))
+	return true;
+    }
+    return false;
+  }  // sp_sentence_text::copy_uint()
+
+  //! copy_bytes() appends the next n bytes in is to parses
+  //
+  bool copy_bytes(std::istream& is, size_t n) {
+    size_t size = parses.size();
+    parses.resize(size + n);
+    return n == 0 || is.read(&parses[size], n);
+  }  // sp_sentence_text::copy_bytes()
+
+  //! copy_binary() appends one sentence in the binary n-best format
+  //! (see binary_nbest_type{}) to parses, unchanged
+  //
+  bool copy_binary(std::istream& is) {
+    unsigned n, nstrings, nnodes, label, child, nparses, root;
+    if (!copy_bytes(is, 2) || !copy_uint(is, n) || !copy_bytes(is, n)
+	|| !copy_uint(is, nstrings))
+      return false;
+    for (unsigned i = 0; i < nstrings; ++i)
+      if (!copy_uint(is, n) || !copy_bytes(is, n))
+	return false;
+    if (!copy_uint(is, nnodes))
+      return false;
+    for (unsigned i = 0; i < nnodes; ++i) {
+      if (!copy_uint(is, label) || !copy_uint(is, n))
+	return false;
+      if (!(label & 1))  // n children follow
+	for (unsigned j = 0; j < n; ++j)
+	  if (!copy_uint(is, child))
+	    return false;
+    }
+    if (!copy_uint(is, nparses))
+      return false;
+    for (unsigned i = 0; i < nparses; ++i)
+      if (!copy_bytes(is, 8) || !copy_uint(is, root))
+	return false;
+    return true;
+  }  // sp_sentence_text::copy_binary()
+
+  //! read_gold() reads the text of the next gold tree and its label
+  //
+  bool read_gold(std::istream& is) {
+    gold.clear();
+    return (is >> gold) && read_tree(is, gold);
+  }  // sp_sentence_text::read_gold()
+
+};  // sp_sentence_text{}
+
+
 // sp_sentences_type is a vector of sp_sentence_type
 //
 typedef std::vector<sp_sentence_type> sp_sentences_type;
@@ -482,6 +803,68 @@ struct sp_corpus_type {
     return nsentences;
   }  // sp_corpus_type::map_sentences_cmd()
 
+  // map_sentences_parallel() calls one of procs on every sentence,
+  // reading the sentences and calling procs on procs.size() threads.
+  // The thread numbered t only calls procs[t], so each Proc can keep
+  // its own statistics and the caller merges them once all are done.
+  // The input is read blocksize sentences at a time, so only that
+  // many are ever held in memory.
+  //
+  template <typename Procs>
+  static size_t map_sentences_parallel(std::istream& parsestream, std::istream& goldstream,
+				       Procs& procs, bool downcase_flag=false,
+				       size_t blocksize=1024) {
+    assert(!procs.empty());
+    size_t nsentences;
+    goldstream >> nsentences;
+    ASSERT(goldstream);
+    std::vector<sp_sentence_text> texts(std::min(blocksize, nsentences));
+    int nthreads = procs.size();
+    for (size_t i0 = 0; i0 < nsentences; i0 += blocksize) {
+      size_t n = std::min(blocksize, nsentences - i0);
+      for (size_t i = 0; i < n; ++i) {
+	if (!texts[i].read_parses(parsestream)) 
+	  std::cerr << "## Error in sp-data.h:map_sentences_parallel(), failed to read n-best parses for sentence " << i0+i << ", nsentences = " << nsentences << std::endl;
+	if (!texts[i].read_gold(goldstream)) 
+	  std::cerr << "## Error in sp-data.h:map_sentences_parallel(), failed to read gold parse for sentence " << i0+i << ", nsentences = " << nsentences << std::endl;
+	ASSERT(parsestream);
+	ASSERT(goldstream);
+      }
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+      for (int i = 0; i < int(n); ++i) {
+#ifdef _OPENMP
+	int t = omp_get_thread_num();
+#else
+	int t = 0;
+#endif
+	std::istringstream parsetext(texts[i].parses), goldtext(texts[i].gold);
+	sp_sentence_type sentence;
+	sentence.read(parsetext, goldtext, downcase_flag);
+	procs[t](sentence);
+      }
+    }
+    return nsentences;
+  }  // sp_corpus_type::map_sentences_parallel()
+
+  // map_sentences_parallel_cmd() calls one of procs on every sentence.
+  //
+  template <typename Procs>
+  static size_t map_sentences_parallel_cmd(const char parsecmd[], const char goldcmd[], 
+					   Procs& procs, bool downcase_flag = false,
+					   size_t blocksize = 1024) {
+    ipstream parsestream(parsecmd);
+    if (!parsestream) {
+      std::cerr << "## Error in sp-data::map_sentences_parallel_cmd(): Can't popen " << parsecmd << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    ipstream goldstream(goldcmd);
+    if (!goldstream) {
+      std::cerr << "## Error in sp-data::map_sentences_parallel_cmd(): Can't popen " << goldcmd << std::endl;
+      std::abort();
+    }
+    return map_sentences_parallel(parsestream, goldstream, procs, downcase_flag, blocksize);
+  }  // sp_corpus_type::map_sentences_parallel_cmd()
+
 };  // sp_corpus_type{}
 
 #endif // SP_DATA_H
@@ -629,19 +629,45 @@ void lnn_unpack_weights_type(Float w[], size_t nhidden, size_t nfeatures,
 }  /* lnn_unpack_weights_type() */
 
 
+/*! lnn_parse_inputs() sets input[j] to the input of hidden unit j for
+ *! parse *p.  w0[] is feature-major, so each feature's weights are a
+ *! contiguous row of nhidden Floats; all of the hidden units' inputs are
+ *! computed in a single pass over p's features, and the inner loops over
+ *! the hidden units vectorize.
+ */
+
+__inline__
+static void lnn_parse_inputs(const parse_type *p, const lnn_weights_type* wt, 
+			     size_t nhidden, Float * __restrict__ input) {
+  size_t j, k;
+  for (j = 0; j < nhidden; ++j)
+    input[j] = wt->b0[j];
+  for (k = 0; k < p->nf; ++k) {          /* features with 1 count */
+    const Float * __restrict__ w0f = &wt->w0[p->f[k]*nhidden];
+    for (j = 0; j < nhidden; ++j)
+      input[j] += w0f[j];
+  }
+  for (k = 0; k < p->nfc; ++k) {         /* features with arbitrary counts */
+    const Float * __restrict__ w0f = &wt->w0[p->fc[k].f*nhidden];
+    Float c = p->fc[k].c;
+    for (j = 0; j < nhidden; ++j)
+      input[j] += c * w0f[j];
+  }
+}  /* lnn_parse_inputs() */
+
+
 /*! lnn_parse_score() sets score0[] (the hidden units scores) and
  *! returns score1 for parse *p. 
  */
 
 __inline__
 static Float lnn_parse_score(parse_type *p, const lnn_weights_type* wt, 
-			     size_t nhidden, size_t nfeatures,
-			     Float score0[]) {
+			     size_t nhidden, Float score0[]) {
   Float score1 = 0;
-  int j;
+  size_t j;
+  lnn_parse_inputs(p, wt, nhidden, score0);
   for (j = 0; j < nhidden; ++j) {
-    Float input = parse_score(p, &wt->w0[j*nfeatures]) + wt->b0[j];
-    score0[j] = tanh(input);  /* tanh sigmoid activation function */
+    score0[j] = tanh(score0[j]);  /* tanh sigmoid activation function */
     score1 += wt->w1[j] * score0[j];
   }
   return score1;
@@ -654,15 +680,14 @@ static Float lnn_parse_score(parse_type *p, const lnn_weights_type* wt,
  */
 
 size_t lnn_sentence_scores(sentence_type *s, const lnn_weights_type* wt, 
-			   size_t nhidden, size_t nfeatures,
-			   Float score0[], Float score1[],
+			   size_t nhidden, Float score0[], Float score1[],
 			   Float *max_correct_score, Float *max_score) {
   int i, best_i = 0, best_correct_i = -1;
   Float sc;
   assert(s->nparses > 0);
 
   *max_score = score1[0] = sc 
-    = lnn_parse_score(&s->parse[0], wt, nhidden, nfeatures, &score0[0]);
+    = lnn_parse_score(&s->parse[0], wt, nhidden, &score0[0]);
 
   if (s->parse[0].Pyx > 0) {
     best_correct_i = 0;
@@ -671,7 +696,7 @@ size_t lnn_sentence_scores(sentence_type *s, const lnn_weights_type* wt,
 
   for (i = 1; i < s->nparses; ++i) {
     score1[i] = sc 
-      = lnn_parse_score(&s->parse[i], wt, nhidden, nfeatures, &score0[i*nhidden]);
+      = lnn_parse_score(&s->parse[i], wt, nhidden, &score0[i*nhidden]);
     if (sc >= *max_score) {
       best_i = i;
       *max_score = sc;
@@ -693,11 +718,12 @@ size_t lnn_sentence_scores(sentence_type *s, const lnn_weights_type* wt,
  *!  increments E_Ew[f] with the difference of the expected 
  *!  value of f for the winners and for all parses,
  *!  and increments the precision/recall scores.
+ *!  backward[] is scratch space for nhidden Floats.
  */
 
 Float lnn_sentence_stats(sentence_type *s, const lnn_weights_type* wt,
-			 size_t nhidden, size_t nfeatures,
-			 Float score0[], Float score1[], 
+			 size_t nhidden,
+			 Float score0[], Float score1[], Float backward[],
 			 const lnn_weights_type* dL_dwt,
 			 Float *sum_g, Float *sum_p, Float *sum_w) 
 { 
@@ -705,7 +731,7 @@ Float lnn_sentence_stats(sentence_type *s, const lnn_weights_type* wt,
   int i, j, k;
   Float Z = 0, logZ, Ecorrect_score = 0;
   
-  size_t best_i = lnn_sentence_scores(s, wt, nhidden, nfeatures,
+  size_t best_i = lnn_sentence_scores(s, wt, nhidden,
 				      score0, score1, 
 				      &max_correct_score, &max_score);
 
@@ -747,16 +773,23 @@ Float lnn_sentence_stats(sentence_type *s, const lnn_weights_type* wt,
     for (j = 0; j < nhidden; ++j) {
       Float g = score0[i*nhidden+j];
       Float dg_dx = 1 - g*g;  /* for tanh activation function */
-      Float backward = cp * wt->w1[j] * dg_dx;
-      dL_dwt->w1[j] += cp * score0[i*nhidden+j];
-      dL_dwt->b0[j] += backward;
-      
-      for (k = 0; k < s->parse[i].nf; ++k)  /* features with 1 count */
-	dL_dwt->w0[j*nfeatures+s->parse[i].f[k]] += backward;
-      
-      for (k = 0; k < s->parse[i].nfc; ++k) /* features with arbitrary counts */
-	dL_dwt->w0[j*nfeatures+s->parse[i].fc[k].f] 
-	  += backward * s->parse[i].fc[k].c;
+      backward[j] = cp * wt->w1[j] * dg_dx;
+      dL_dwt->w1[j] += cp * g;
+      dL_dwt->b0[j] += backward[j];
+    }
+
+    /* scatter backward[] into each feature's row of dL_dw0 */
+
+    for (k = 0; k < s->parse[i].nf; ++k) {  /* features with 1 count */
+      Float * __restrict__ dw0f = &dL_dwt->w0[s->parse[i].f[k]*nhidden];
+      for (j = 0; j < nhidden; ++j)
+	dw0f[j] += backward[j];
+    }
+    for (k = 0; k < s->parse[i].nfc; ++k) { /* features with arbitrary counts */
+      Float * __restrict__ dw0f = &dL_dwt->w0[s->parse[i].fc[k].f*nhidden];
+      Float c = s->parse[i].fc[k].c;
+      for (j = 0; j < nhidden; ++j)
+	dw0f[j] += backward[j] * c;
     }
   }
   return - s->Px * (Ecorrect_score - logZ);
@@ -775,11 +808,13 @@ Float lnn_corpus_stats(corpus_type *c, size_t nhidden,
   Float neglogP = 0;
   Float *score1 = MALLOC(c->maxnparses*sizeof(Float));
   Float *score0 = MALLOC(nhidden * c->maxnparses*sizeof(Float));
+  Float *backward = MALLOC(nhidden*sizeof(Float));
 
   int i;
   
   assert(score1 != NULL);
   assert(score0 != NULL);
+  assert(backward != NULL);
 
   *sum_g = *sum_p = *sum_w = 0;          /* zero precision/recall counters */
 
@@ -790,9 +825,10 @@ Float lnn_corpus_stats(corpus_type *c, size_t nhidden,
   lnn_unpack_weights_type(dL_dw, nhidden, c->nfeatures, &dL_dwt);
 
   for (i = 0; i < c->nsentences; ++i)  /* collect stats from sentences */
-    neglogP += lnn_sentence_stats(&c->sentence[i], &wt, nhidden, c->nfeatures, 
-				  score0, score1, &dL_dwt, sum_g, sum_p, sum_w);
+    neglogP += lnn_sentence_stats(&c->sentence[i], &wt, nhidden,
+				  score0, score1, backward, &dL_dwt, sum_g, sum_p, sum_w);
 
+  FREE(backward);
   FREE(score0);
   FREE(score1);
   return neglogP;
@@ -165,7 +165,7 @@ void wap_sentence(sentence_type *s, Float score[], Float w[],
 typedef struct {
   Float *w1;            /*!< level 1 weights: w1[nhidden]            */
   Float *b0;            /*!< level 0 biases:  b0[nhidden]            */
-  Float *w0;            /*!< level 0 weights: w0[nhidden][nfeatures] */
+  Float *w0;            /*!< level 0 weights: w0[nfeatures][nhidden] */
 } lnn_weights_type;
 
 /*! lnn_unpack_weights_type() sets a lnn_weights_type to point to the appropriate
@@ -261,31 +261,76 @@ int main(int argc, char* argv[])
   	    << std::endl;
 
   if (nseparators >= 0) {
-    for (size_t leftout = 0; leftout < fc.nc; ++leftout) {
-      Floats xs1(xs);
-      size_t nleftout = 0;
-      sum = 0;
-      sum_sq = 0;
-      n_nonzero = 0;
-      for (size_t j = 0; j < fc.f_c.size(); ++j)
-	if (fc.f_c[j] == leftout) {
-	  xs1[j] = 0;
-	  ++nleftout;
-	  if (xs[j] != 0) {
-	    ++n_nonzero;
-	    sum += xs[j];
-	    sum_sq += xs[j] * xs[j];
+    // Zeroing a class' weights only changes the scores of the parses
+    // with features in that class, by that class' part of their scores.
+    // So cache each sentence's parse scores and statistics, and each
+    // parse's per-class scores, and for each class only rescore the
+    // sentences it occurs in.
+
+    std::vector<size_type> f_c(fc.f_c.begin(), fc.f_c.end());
+    corpus_partition_classes(eval, &f_c[0], fc.nc);
+
+    std::vector<Floats> scores(eval->nsentences);
+    Floats neglogPs(eval->nsentences), gs(eval->nsentences), 
+      ps(eval->nsentences), ws(eval->nsentences);
+    std::vector<std::vector<size_t> > c_sentences(fc.nc);
+    std::vector<size_t> c_last(fc.nc, eval->nsentences);
+    for (size_t i = 0; i < eval->nsentences; ++i) {
+      sentence_type* s = &eval->sentence[i];
+      scores[i].resize(s->nparses);
+      for (size_t k = 0; k < s->nparses; ++k) {
+	parse_type* p = &s->parse[k];
+	scores[i][k] = parse_class_scores(p, &xs[0]);
+	for (size_t r = 0; r < p->nruns; ++r) 
+	  if (c_last[p->run[r].c] != i) {
+	    c_last[p->run[r].c] = i;
+	    c_sentences[p->run[r].c].push_back(i);
 	  }
-	}
+      }
+      Float g0 = 0, p0 = 0, w0 = 0;
+      neglogPs[i] = s->nparses > 0 
+	? sentence_scores_stats(s, &scores[i][0], &g0, &p0, &w0)
+	: sentence_scores_stats(s, NULL, &g0, &p0, &w0);
+      gs[i] = g0;
+      ps[i] = p0;
+      ws[i] = w0;
+    }
+
+    std::vector<size_t> c_nleftout(fc.nc), c_nonzero(fc.nc);
+    Floats c_sum(fc.nc), c_sum_sq(fc.nc);
+    for (size_t j = 0; j < fc.f_c.size(); ++j) {
+      size_t c = fc.f_c[j];
+      ++c_nleftout[c];
+      if (xs[j] != 0) {
+	++c_nonzero[c];
+	c_sum[c] += xs[j];
+	c_sum_sq[c] += xs[j] * xs[j];
+      }
+    }
+
+    Floats score1(eval->maxnparses);
+    for (size_t leftout = 0; leftout < fc.nc; ++leftout) {
+      Float dneglogP = 0, g = g_all, p = p_all, w = w_all;
+      cforeach (std::vector<size_t>, it, c_sentences[leftout]) {
+	size_t i = *it;
+	sentence_type* s = &eval->sentence[i];
+	for (size_t k = 0; k < s->nparses; ++k)
+	  score1[k] = scores[i][k] - parse_class_score(&s->parse[k], leftout);
+	Float g0 = 0, p0 = 0, w0 = 0;
+	dneglogP += sentence_scores_stats(s, &score1[0], &g0, &p0, &w0) - neglogPs[i];
+	g += g0 - gs[i];
+	p += p0 - ps[i];
+	w += w0 - ws[i];
+      }
       
-      Float neglogP, fscore, g = 0, p = 0, w = 0;
-      evaluate(eval, xs1, neglogP, g, p, w, fscore);
+      size_t nleftout = c_nleftout[leftout];
+      Float fscore = 2*w/(g+p);
       std::cout << fscore-fscore_all
-		<< '\t' << neglogP-neglogP_all
+		<< '\t' << dneglogP
 		<< '\t' << nleftout
-		<< '\t' << n_nonzero
-		<< '\t' << sum/nleftout
-		<< '\t' << (sum_sq - sum*sum/nleftout)/(nleftout-1)
+		<< '\t' << c_nonzero[leftout]
+		<< '\t' << c_sum[leftout]/nleftout
+		<< '\t' << (c_sum_sq[leftout] - c_sum[leftout]*c_sum[leftout]/nleftout)/(nleftout-1)
 		<< '\t' << fc.regclass_identifiers[leftout]
 		<< std::endl;
     }
@@ -260,6 +260,9 @@ static void read_parse(FILE *in, parse_type *p, feature_type *fmax) {
   if (nfc > 0)
     assert(p->fc != NULL);
 
+  p->run = NULL;
+  p->nruns = 0;
+
   fscanf(in, " ,");   /* read final ',' */
 
 }  /* read_parse() */
@@ -455,6 +458,115 @@ corpus_type *read_corpus_file(corpusflags_type *flags, const char* filename) {
   return corpus;
 }  /* read_corpus_file() */
 
+
+static int size_type_cmp(const void *a, const void *b) {
+  size_type x = *(const size_type *) a, y = *(const size_type *) b;
+  return x < y ? -1 : x > y;
+}  /* size_type_cmp() */
+
+void corpus_partition_classes(corpus_type *c, const size_type feat_class[], 
+			      size_type nclasses) {
+  /* per-class counts and then write positions, and the classes
+     seen in the current parse */
+  size_type *nf_c = CALLOC(nclasses, sizeof(size_type));
+  size_type *nfc_c = CALLOC(nclasses, sizeof(size_type));
+  size_type *classes = MALLOC(nclasses*sizeof(size_type));
+  size_type fbuf_n = MIN_NF, fcbuf_n = MIN_NFC;
+  feature_type *fbuf = MALLOC(fbuf_n*sizeof(feature_type));
+  fc_type *fcbuf = MALLOC(fcbuf_n*sizeof(fc_type));
+  size_type i, j, k;
+  assert(nf_c != NULL && nfc_c != NULL && classes != NULL);
+  assert(fbuf != NULL && fcbuf != NULL);
+
+  for (i = 0; i < c->nsentences; ++i)
+    for (j = 0; j < c->sentence[i].nparses; ++j) {
+      parse_type *p = &c->sentence[i].parse[j];
+      size_type nclassesp = 0, f_end = 0, fc_end = 0;
+
+      for (k = 0; k < p->nf; ++k) {
+	size_type cl = feat_class[p->f[k]];
+	assert(cl < nclasses);
+	if (nf_c[cl]++ == 0 && nfc_c[cl] == 0)
+	  classes[nclassesp++] = cl;
+      }
+      for (k = 0; k < p->nfc; ++k) {
+	size_type cl = feat_class[p->fc[k].f];
+	assert(cl < nclasses);
+	if (nfc_c[cl]++ == 0 && nf_c[cl] == 0)
+	  classes[nclassesp++] = cl;
+      }
+      qsort(classes, nclassesp, sizeof(size_type), size_type_cmp);
+
+      p->nruns = nclassesp;
+      p->run = SMALLOC(nclassesp*sizeof(classrun_type));
+      if (nclassesp > 0)
+	assert(p->run != NULL);
+      for (k = 0; k < nclassesp; ++k) {   /* counts -> start positions */
+	size_type cl = classes[k], nf = nf_c[cl], nfc = nfc_c[cl];
+	nf_c[cl] = f_end;
+	nfc_c[cl] = fc_end;
+	p->run[k].c = cl;
+	p->run[k].f_end = f_end += nf;
+	p->run[k].fc_end = fc_end += nfc;
+      }
+
+      if (p->nf > fbuf_n) {
+	fbuf = REALLOC(fbuf, (fbuf_n = p->nf)*sizeof(feature_type));
+	assert(fbuf != NULL);
+      }
+      if (p->nfc > fcbuf_n) {
+	fcbuf = REALLOC(fcbuf, (fcbuf_n = p->nfc)*sizeof(fc_type));
+	assert(fcbuf != NULL);
+      }
+      for (k = 0; k < p->nf; ++k)        /* stable, so each run keeps its order */
+	fbuf[nf_c[feat_class[p->f[k]]]++] = p->f[k];
+      for (k = 0; k < p->nfc; ++k)
+	fcbuf[nfc_c[feat_class[p->fc[k].f]]++] = p->fc[k];
+      memcpy(p->f, fbuf, p->nf*sizeof(feature_type));
+      memcpy(p->fc, fcbuf, p->nfc*sizeof(fc_type));
+
+      for (k = 0; k < nclassesp; ++k)
+	nf_c[classes[k]] = nfc_c[classes[k]] = 0;
+    }
+
+  FREE(nf_c);
+  FREE(nfc_c);
+  FREE(classes);
+  FREE(fbuf);
+  FREE(fcbuf);
+}  /* corpus_partition_classes() */
+
+Float parse_class_scores(parse_type *p, const Float w[]) {
+  size_type i, r, f_begin = 0, fc_begin = 0;
+  Float score = 0;
+  assert(p->run != NULL || p->nf + p->nfc == 0);
+  for (r = 0; r < p->nruns; ++r) {
+    classrun_type *run = &p->run[r];
+    Float sc = 0;
+    for (i = f_begin; i < run->f_end; ++i)
+      sc += w[p->f[i]];
+    for (i = fc_begin; i < run->fc_end; ++i)
+      sc += p->fc[i].c * w[p->fc[i].f];
+    run->score = sc;
+    score += sc;
+    f_begin = run->f_end;
+    fc_begin = run->fc_end;
+  }
+  return score;
+}  /* parse_class_scores() */
+
+Float parse_class_score(const parse_type *p, size_type c) {
+  size_type lo = 0, hi = p->nruns;   /* runs are sorted by class */
+  while (lo < hi) {
+    size_type mid = lo + (hi - lo)/2;
+    if (p->run[mid].c < c)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < p->nruns && p->run[lo].c == c ? p->run[lo].score : 0;
+}  /* parse_class_score() */
+
 /***********************************************************************
  *                                                                     *
  *                      linear logistic regression                     *
@@ -565,6 +677,45 @@ Float sentence_stats(sentence_type *s, const Float w[], Float score[], Float E_E
   }
   return - s->Px * (Ecorrect_score - logZ);
 }  /* sentence_stats() */
+
+/*! sentence_scores_stats() returns - log P~(x) (E_P~[w.f|x] - log Z_w(x))
+ *!  for parse scores score[], and increments the precision/recall scores.
+ *!  Ties are broken as in sentence_scores().
+ */
+
+Float sentence_scores_stats(const sentence_type *s, const Float score[],
+			    Float *sum_g, Float *sum_p, Float *sum_w) {
+  Float best_score;
+  int i, best_i = 0;
+  Float Z = 0, logZ, Ecorrect_score = 0;
+
+  *sum_g += s->g;
+
+  if (s->nparses <= 0) 
+    return 0;
+
+  best_score = score[0];
+  for (i = 1; i < s->nparses; ++i)
+    if (score[i] >= best_score) {
+      best_i = i;
+      best_score = score[i];
+    }
+  assert(finite(best_score));
+  *sum_p += s->parse[best_i].p;
+  *sum_w += s->parse[best_i].w;
+  
+  if (s->Px == 0)  /* skip statistics calculation if Px == 0 */
+    return 0;
+
+  for (i = 0; i < s->nparses; ++i) {   /* compute Z */
+    Z += exp(score[i] - best_score);
+    if (s->parse[i].Pyx > 0) 
+      Ecorrect_score += s->parse[i].Pyx * score[i];
+  }
+
+  logZ = log(Z) + best_score;
+  return - s->Px * (Ecorrect_score - logZ);
+}  /* sentence_scores_stats() */
   
 
 /* corpus_stats() returns - count * log P(winners|parses), 
@@ -1385,6 +1536,7 @@ void wap_sentence(sentence_type *s, Float w[],
  *                                                                     *
  ***********************************************************************/
 
+
 /*! lnn_unpack_weights_type() sets a lnn_weights_type to point to the appropriate
  *! places in the single long weight vector w[].
  */
@@ -1398,19 +1550,45 @@ void lnn_unpack_weights_type(Float w[], size_type nhidden, size_type nfeatures,
 }  /* lnn_unpack_weights_type() */
 
 
+/*! lnn_parse_inputs() sets input[j] to the input of hidden unit j for
+ *! parse *p.  w0[] is feature-major, so each feature's weights are a
+ *! contiguous row of nhidden Floats; all of the hidden units' inputs are
+ *! computed in a single pass over p's features, and the inner loops over
+ *! the hidden units vectorize.
+ */
+
+__inline__
+static void lnn_parse_inputs(const parse_type *p, const lnn_weights_type* wt, 
+			     size_type nhidden, Float * __restrict__ input) {
+  size_type j, k;
+  for (j = 0; j < nhidden; ++j)
+    input[j] = wt->b0[j];
+  for (k = 0; k < p->nf; ++k) {          /* features with 1 count */
+    const Float * __restrict__ w0f = &wt->w0[(size_t) p->f[k]*nhidden];
+    for (j = 0; j < nhidden; ++j)
+      input[j] += w0f[j];
+  }
+  for (k = 0; k < p->nfc; ++k) {         /* features with arbitrary counts */
+    const Float * __restrict__ w0f = &wt->w0[(size_t) p->fc[k].f*nhidden];
+    Float c = p->fc[k].c;
+    for (j = 0; j < nhidden; ++j)
+      input[j] += c * w0f[j];
+  }
+}  /* lnn_parse_inputs() */
+
+
 /*! lnn_parse_score() sets score0[] (the hidden units scores) and
  *! returns score1 for parse *p. 
  */
 
 __inline__
 static Float lnn_parse_score(parse_type *p, const lnn_weights_type* wt, 
-			     size_type nhidden, size_type nfeatures,
-			     Float score0[]) {
+			     size_type nhidden, Float score0[]) {
   Float score1 = 0;
-  int j;
+  size_type j;
+  lnn_parse_inputs(p, wt, nhidden, score0);
   for (j = 0; j < nhidden; ++j) {
-    Float input = parse_score(p, &wt->w0[j*nfeatures]) + wt->b0[j];
-    score0[j] = tanh(input);  /* tanh sigmoid activation function */
+    score0[j] = tanh(score0[j]);  /* tanh sigmoid activation function */
     score1 += wt->w1[j] * score0[j];
   }
   return score1;
@@ -1422,7 +1600,7 @@ static Float lnn_parse_score(parse_type *p, const lnn_weights_type* wt,
  */
 
 void lnn_sentence_scores(sentence_type *s, const lnn_weights_type* wt, 
-			 size_type nhidden, size_type nfeatures,
+			 size_type nhidden, 
 			 Float score0[], Float score1[],
 			 Float *best_correct_score, int *best_correct_i,
 			 Float *best_score, int *best_i) {
@@ -1434,7 +1612,7 @@ void lnn_sentence_scores(sentence_type *s, const lnn_weights_type* wt,
   *best_correct_i = -1;
 
   *best_score = score1[0] = sc 
-    = lnn_parse_score(&s->parse[0], wt, nhidden, nfeatures, &score0[0]);
+    = lnn_parse_score(&s->parse[0], wt, nhidden, &score0[0]);
 
   if (s->parse[0].Pyx > 0) {
     *best_correct_i = 0;
@@ -1443,7 +1621,7 @@ void lnn_sentence_scores(sentence_type *s, const lnn_weights_type* wt,
 
   for (i = 1; i < s->nparses; ++i) {
     score1[i] = sc 
-      = lnn_parse_score(&s->parse[i], wt, nhidden, nfeatures, &score0[i*nhidden]);
+      = lnn_parse_score(&s->parse[i], wt, nhidden, &score0[i*nhidden]);
     if (sc >= *best_score) {
       *best_i = i;
       *best_score = sc;
@@ -1464,21 +1642,23 @@ void lnn_sentence_scores(sentence_type *s, const lnn_weights_type* wt,
  *!  increments E_Ew[f] with the difference of the expected 
  *!  value of f for the winners and for all parses,
  *!  and increments the precision/recall scores.
+ *!  backward[] is scratch space for nhidden Floats.
  */
 
 Float lnn_sentence_stats(sentence_type *s, const lnn_weights_type* wt,
-			 size_type nhidden, size_type nfeatures,
-			 Float score0[], Float score1[], 
+			 size_type nhidden, 
+			 Float score0[], Float score1[], Float backward[],
 			 const lnn_weights_type* dL_dwt,
 			 Float *sum_g, Float *sum_p, Float *sum_w) 
 { 
   Float best_correct_score, best_score;
-  int i, j, k, best_i = 0, best_correct_i = 0;
+  int i, best_i = 0, best_correct_i = 0;
+  size_type j, k;
   Float Z = 0, logZ, Ecorrect_score = 0;
 
   *sum_g += s->g;
 
-  lnn_sentence_scores(s, wt, nhidden, nfeatures,
+  lnn_sentence_scores(s, wt, nhidden,
 		      score0, score1, 
 		      &best_correct_score, &best_correct_i,
 		      &best_score, &best_i);
@@ -1504,11 +1684,12 @@ Float lnn_sentence_stats(sentence_type *s, const lnn_weights_type* wt,
   /* calculate expectations */
 
   for (i = 0; i < s->nparses; ++i) {
+    const parse_type *p = &s->parse[i];
     Float cp = exp(score1[i] - logZ);  /* P_w(y|x) */
     assert(finite(cp));
 
-    if (s->parse[i].Pyx > 0)  /* P_e(y|x)  */
-      cp -= s->parse[i].Pyx;
+    if (p->Pyx > 0)  /* P_e(y|x)  */
+      cp -= p->Pyx;
 
     assert(cp >= -1.0);
     assert(cp <= 1.0);
@@ -1520,16 +1701,23 @@ Float lnn_sentence_stats(sentence_type *s, const lnn_weights_type* wt,
     for (j = 0; j < nhidden; ++j) {
       Float g = score0[i*nhidden+j];
       Float dg_dx = 1 - g*g;  /* for tanh activation function */
-      Float backward = cp * wt->w1[j] * dg_dx;
-      dL_dwt->w1[j] += cp * score0[i*nhidden+j];
-      dL_dwt->b0[j] += backward;
-      
-      for (k = 0; k < s->parse[i].nf; ++k)  /* features with 1 count */
-	dL_dwt->w0[j*nfeatures+s->parse[i].f[k]] += backward;
-      
-      for (k = 0; k < s->parse[i].nfc; ++k) /* features with arbitrary counts */
-	dL_dwt->w0[j*nfeatures+s->parse[i].fc[k].f] 
-	  += backward * s->parse[i].fc[k].c;
+      backward[j] = cp * wt->w1[j] * dg_dx;
+      dL_dwt->w1[j] += cp * g;
+      dL_dwt->b0[j] += backward[j];
+    }
+
+    /* scatter backward[] into each feature's row of dL_dw0 */
+
+    for (k = 0; k < p->nf; ++k) {          /* features with 1 count */
+      Float * __restrict__ dw0f = &dL_dwt->w0[(size_t) p->f[k]*nhidden];
+      for (j = 0; j < nhidden; ++j)
+	dw0f[j] += backward[j];
+    }
+    for (k = 0; k < p->nfc; ++k) {         /* features with arbitrary counts */
+      Float * __restrict__ dw0f = &dL_dwt->w0[(size_t) p->fc[k].f*nhidden];
+      Float c = p->fc[k].c;
+      for (j = 0; j < nhidden; ++j)
+	dw0f[j] += backward[j] * c;
     }
   }
   return - s->Px * (Ecorrect_score - logZ);
@@ -1544,29 +1732,83 @@ Float lnn_corpus_stats(corpus_type *c, size_type nhidden,
 		       Float w[], Float dL_dw[],
 		       Float *sum_g, Float *sum_p, Float *sum_w) 
 {
-  lnn_weights_type wt, dL_dwt;
+  size_t nw = (size_t) nhidden*(c->nfeatures+2);
+  lnn_weights_type wt;
   Float neglogP = 0;
-  Float *score1 = MALLOC(c->maxnparses*sizeof(Float));
-  Float *score0 = MALLOC(nhidden * c->maxnparses*sizeof(Float));
-
-  int i;
+  size_t i;
   
-  assert(score1 != NULL);
-  assert(score0 != NULL);
-
   *sum_g = *sum_p = *sum_w = 0;          /* zero precision/recall counters */
 
-  for (i = 0; i < nhidden*(c->nfeatures+2); ++i) 
+  for (i = 0; i < nw; ++i) 
     dL_dw[i] = 0;    /* zero dL_dw[] */
 
   lnn_unpack_weights_type(w, nhidden, c->nfeatures, &wt);
-  lnn_unpack_weights_type(dL_dw, nhidden, c->nfeatures, &dL_dwt);
 
-  for (i = 0; i < c->nsentences; ++i)  /* collect stats from sentences */
-    neglogP += lnn_sentence_stats(&c->sentence[i], &wt, nhidden, c->nfeatures, 
-				  score0, score1, &dL_dwt, sum_g, sum_p, sum_w);
+#ifdef _OPENMP
+# pragma omp parallel default(shared)
+  {
+    lnn_weights_type local_dL_dwt;
+    Float *local_dL_dw = MALLOC(nw*sizeof(Float));
+    Float *score1 = MALLOC(c->maxnparses*sizeof(Float));
+    Float *score0 = MALLOC(nhidden * c->maxnparses*sizeof(Float));
+    Float *backward = MALLOC(nhidden*sizeof(Float));
+    Float local_sum_g = 0, local_sum_p = 0, local_sum_w = 0, local_neglogP = 0;
+    size_t f;
+    int j;
+
+    assert(local_dL_dw != NULL);
+    assert(score1 != NULL);
+    assert(score0 != NULL);
+    assert(backward != NULL);
+
+    for (f = 0; f < nw; ++f)
+      local_dL_dw[f] = 0;
+    lnn_unpack_weights_type(local_dL_dw, nhidden, c->nfeatures, &local_dL_dwt);
+
+# pragma omp for schedule(dynamic, 16)
+    for (j = 0; j < c->nsentences; ++j)  /* collect stats from sentences */
+      local_neglogP += lnn_sentence_stats(&c->sentence[j], &wt, nhidden, 
+					  score0, score1, backward, &local_dL_dwt, 
+					  &local_sum_g, &local_sum_p, &local_sum_w);
+
+    FREE(backward);
+    FREE(score0);
+    FREE(score1);
+
+# pragma omp critical (lmdata_lnn_corpus_stats)
+    {
+      neglogP += local_neglogP;
+      *sum_g += local_sum_g;
+      *sum_p += local_sum_p;
+      *sum_w += local_sum_w;
+      for (f = 0; f < nw; ++f)
+	dL_dw[f] += local_dL_dw[f];
+    }
 
-  FREE(score0);
-  FREE(score1);
+    FREE(local_dL_dw);
+  }  /* pragma omp parallel */
+#else
+  {
+    lnn_weights_type dL_dwt;
+    Float *score1 = MALLOC(c->maxnparses*sizeof(Float));
+    Float *score0 = MALLOC(nhidden * c->maxnparses*sizeof(Float));
+    Float *backward = MALLOC(nhidden*sizeof(Float));
+
+    assert(score1 != NULL);
+    assert(score0 != NULL);
+    assert(backward != NULL);
+
+    lnn_unpack_weights_type(dL_dw, nhidden, c->nfeatures, &dL_dwt);
+
+    for (i = 0; i < c->nsentences; ++i)  /* collect stats from sentences */
+      neglogP += lnn_sentence_stats(&c->sentence[i], &wt, nhidden, 
+				    score0, score1, backward, &dL_dwt, 
+				    sum_g, sum_p, sum_w);
+
+    FREE(backward);
+    FREE(score0);
+    FREE(score1);
+  }
+#endif
   return neglogP;
 }  /* lnn_corpus_stats() */
@@ -57,11 +57,28 @@ typedef struct {
   DataFloat c;                /* number of times feature occured */
 } fc_type;
 
+/*! classrun_type{} describes a parse's features in one feature class,
+ *! once corpus_partition_classes() has grouped them by class.  The
+ *! class' features with count 1 are f[f_begin..f_end) and its feature
+ *! counts fc[fc_begin..fc_end), where f_begin and fc_begin are the
+ *! previous run's ends (0 for the first run).  score caches the class'
+ *! contribution to the parse's score (see parse_class_scores()).
+ */
+
+typedef struct {
+  size_type c;                /* feature class */
+  size_type f_end;            /* end of the class' features with count 1 */
+  size_type fc_end;           /* end of the class' feature counts */
+  Float score;                /* the class' part of the parse's score */
+} classrun_type;
+
 typedef struct {
   feature_type *f;            /* array of features with count 1 */
   size_type  nf;              /* number of features with count 1 */
   fc_type *fc;                /* array of feature counts */
   size_type  nfc;             /* number of feature counts */
+  classrun_type *run;         /* runs of features by class, NULL if not partitioned */
+  size_type  nruns;           /* number of runs, i.e., classes with features */
   DataFloat   Pyx;            /* probability this parse is correct, 0 when not correct */
   DataFloat   p;	      /* number of parse edges */
   DataFloat   w;	      /* number of correct parse edges */
@@ -98,6 +115,25 @@ corpus_type *read_corpus(corpusflags_type *flags, FILE *in);
 
 corpus_type *read_corpus_file(corpusflags_type *flags, const char* filename);
 
+/*! corpus_partition_classes() sorts each parse's features by their
+ *! class feat_class[f] (< nclasses) and sets its class runs.
+ */
+
+void corpus_partition_classes(corpus_type *c, const size_type feat_class[], 
+			      size_type nclasses);
+
+/*! parse_class_scores() returns the score for partitioned parse *p, and
+ *! caches each class' part of it in p's runs.
+ */
+
+Float parse_class_scores(parse_type *p, const Float w[]);
+
+/*! parse_class_score() returns class c's part of partitioned parse *p's
+ *! score, as cached by parse_class_scores() (0 if p has no features in c).
+ */
+
+Float parse_class_score(const parse_type *p, size_type c);
+
 
 /***********************************************************************
  *                                                                     *
@@ -116,6 +152,13 @@ corpus_type *read_corpus_file(corpusflags_type *flags, const char* filename);
 Float sentence_stats(sentence_type *s, const Float w[], Float score[], Float E_Ew[],
 		     Float *sum_g, Float *sum_p, Float *sum_w);
 
+/*! sentence_scores_stats() is like sentence_stats(), except that it takes
+ *!  the parses' scores in score[] and doesn't compute the derivative.
+ */
+
+Float sentence_scores_stats(const sentence_type *s, const Float score[],
+			    Float *sum_g, Float *sum_p, Float *sum_w);
+
 Float corpus_stats(corpus_type *c, const Float w[], Float E_Ew[], 
 	           Float *sum_g, Float *sum_p, Float *sum_w);
 
@@ -246,7 +289,7 @@ void wap_sentence(sentence_type *s, Float w[],
 typedef struct {
   Float *w1;            /*!< level 1 weights: w1[nhidden]            */
   Float *b0;            /*!< level 0 biases:  b0[nhidden]            */
-  Float *w0;            /*!< level 0 weights: w0[nhidden][nfeatures] */
+  Float *w0;            /*!< level 0 weights: w0[nfeatures][nhidden] */
 } lnn_weights_type;
 
 /*! lnn_unpack_weights_type() sets a lnn_weights_type to point to the appropriate
@@ -16,6 +16,7 @@
 
 #include "custom_allocator.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <string>
@@ -55,7 +56,8 @@ size_type relabel(tree* t, const edges& es,
     right = relabel(c, es, right, true);
 
   if (nonrootnode && right > left)       // ignore root node
-    if (es.count(edge(left, right, precrec_type::relabel_category(t->label.cat))) == 0) 
+    if (!std::binary_search(es.begin(), es.end(),
+			    edge(left, right, precrec_type::relabel_category(t->label.cat)))) 
       t->label.cat = relabel(t->label.cat);
     
   return right;
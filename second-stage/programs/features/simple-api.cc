@@ -14,6 +14,7 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <pthread.h>
 #include <vector>
 #include <string>
 
@@ -26,6 +27,9 @@
 
 #include "simple-api.h"
 
+// parser headers go last since they pull in "using namespace std"
+#include "InputTree.h"
+
 // externed variables
 int debug_level = 0;
 bool absolute_counts = true;
@@ -89,6 +93,80 @@ RerankerModel::scoreNBestList(const sp_sentence_type& nbest_list) const {
     return parse_scores;
 }
 
+// Scores the parser's n-best list directly (see convertNBestList()).
+// Scores are in the same order as scored_trees.
+Weights* RerankerModel::scoreParses(const std::vector<ScoredTree>& scored_trees,
+        bool lowercase) const {
+    sp_sentence_type nbest_list;
+    nbest_list.set(scored_trees, "", lowercase);
+    return scoreNBestList(nbest_list);
+}
+
+// shared state for the worker threads in scoreBatch()
+struct ScoreBatchState {
+    const RerankerModel* model;
+    const std::vector<std::vector<ScoredTree> >* nbest_lists;
+    std::vector<Weights>* scores;
+    bool lowercase;
+    size_t next_index;
+    pthread_mutex_t lock;
+};
+
+static void* scoreBatchWorker(void* arg) {
+    ScoreBatchState* state = reinterpret_cast<ScoreBatchState*>(arg);
+    for ( ; ; ) {
+        pthread_mutex_lock(&state->lock);
+        size_t index = state->next_index++;
+        pthread_mutex_unlock(&state->lock);
+        if (index >= state->nbest_lists->size()) {
+            break;
+        }
+        const std::vector<ScoredTree>& scored_trees =
+            (*state->nbest_lists)[index];
+        if (scored_trees.empty()) {
+            continue;
+        }
+        Weights* scores = state->model->scoreParses(scored_trees,
+                                                    state->lowercase);
+        (*state->scores)[index].swap(*scores);
+        delete scores;
+    }
+    return 0;
+}
+
+// Scores a batch of the parser's n-best lists (e.g., from its
+// parseBatch()) on num_threads threads, as scoreParses() would score
+// each one. Empty n-best lists get empty score vectors.
+std::vector<Weights>* RerankerModel::scoreBatch(
+        const std::vector<std::vector<ScoredTree> >& nbest_lists,
+        bool lowercase, int num_threads) const {
+    std::vector<Weights>* scores = new std::vector<Weights>(nbest_lists.size());
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    if (size_t(num_threads) > nbest_lists.size()) {
+        num_threads = nbest_lists.size();
+    }
+
+    ScoreBatchState state;
+    state.model = this;
+    state.nbest_lists = &nbest_lists;
+    state.scores = scores;
+    state.lowercase = lowercase;
+    state.next_index = 0;
+    pthread_mutex_init(&state.lock, NULL);
+
+    std::vector<pthread_t> threads(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+        pthread_create(&threads[i], NULL, scoreBatchWorker, &state);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&state.lock);
+    return scores;
+}
+
 sp_sentence_type* readNBestList(const std::string nbest_list, bool lowercase) {
     std::stringstream text(nbest_list);
     sp_sentence_type* s = new sp_sentence_type();
@@ -96,3 +174,13 @@ sp_sentence_type* readNBestList(const std::string nbest_list, bool lowercase) {
 
     return s;
 }
+
+// Builds the reranker's n-best list directly from the parser's trees
+// rather than printing them and reading them back with readNBestList().
+sp_sentence_type* convertNBestList(const std::vector<ScoredTree>& scored_trees,
+        const std::string label, bool lowercase) {
+    sp_sentence_type* s = new sp_sentence_type();
+    s->set(scored_trees, label, lowercase);
+
+    return s;
+}
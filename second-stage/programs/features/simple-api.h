@@ -23,6 +23,10 @@ class RerankerError {
 
 typedef std::vector<Float> Weights;
 
+// the first-stage parser's n-best lists (see first-stage/PARSE/SimpleAPI.h)
+class InputTree;
+typedef std::pair<double,InputTree*> ScoredTree;
+
 void setOptions(int debug, bool abs_counts);
 
 class RerankerModel {
@@ -36,6 +40,14 @@ class RerankerModel {
                 const char* feature_weights_filename);
 
         Weights* scoreNBestList(const sp_sentence_type& nbest_list) const;
+        Weights* scoreParses(const std::vector<ScoredTree>& scored_trees,
+                bool lowercase) const;
+        std::vector<Weights>* scoreBatch(
+                const std::vector<std::vector<ScoredTree> >& nbest_lists,
+                bool lowercase, int num_threads) const;
 };
 
 sp_sentence_type* readNBestList(const std::string nbest_list, bool lowercase);
+
+sp_sentence_type* convertNBestList(const std::vector<ScoredTree>& scored_trees,
+        const std::string label, bool lowercase);
@@ -48,6 +48,147 @@ tree_node<label_type>* strip_function_tags(tree_node<label_type>* tp) {
   return tp;
 }
 
+// parser_tree_tree() copies a tree built by the first-stage parser
+// (an InputTree, or anything with the same accessors) into a tree.
+// It produces the same tree as printing the parser's tree and reading
+// it back in, but without the round trip through text.  The parser's
+// preterminals hold their word directly, so they get a terminal child.
+//
+template <typename parser_tree_type>
+tree* parser_tree_tree(parser_tree_type* tp);
+
+template <typename parser_tree_iterator>
+tree* parser_trees_tree(parser_tree_iterator it, parser_tree_iterator end) {
+  if (it == end)
+    return NULL;
+  tree* tp = parser_tree_tree(*it);
+  tp->next = parser_trees_tree(++it, end);
+  return tp;
+}
+
+template <typename parser_tree_type>
+tree* parser_tree_tree(parser_tree_type* tp) {
+  assert(tp != NULL);
+  if (!tp->word().empty())
+    return new tree(tree::label_type::cat_type(tp->term()),
+		    new tree(tree::label_type::cat_type(tp->word())));
+  return new tree(tree::label_type::cat_type(tp->term() + tp->ntInfo()),
+		  parser_trees_tree(tp->subTrees().begin(), tp->subTrees().end()));
+}
+
+// binary_nbest_type{} holds the label, word and node tables of one
+// sentence in the binary n-best format written by parseIt -b (see
+// first-stage/PARSE/BinaryNBest.h for the format).  Nodes are shared
+// between parses in the file, but node_tree() builds separate trees.
+//
+struct binary_nbest_type {
+  static const char magic = 0x02;
+  static const char version = 1;
+
+  struct node_type {
+    unsigned label;
+    unsigned word;   // only used by preterminals
+    bool preterminal;
+    std::vector<unsigned> children;
+  };
+
+  std::vector<std::string> strings;
+  std::vector<node_type> nodes;
+
+  static bool read_uint(std::istream& is, unsigned& n) {
+    n = 0;
+    char c;
+    for (unsigned shift = 0; shift < 32 && is.get(c); shift += 7) {
+      n |= (unsigned(c) & 0x7f) << shift;
+      if (!(c & 0x80))
+	return true;
+    }
+    is.setstate(std::ios::failbit);
+    return false;
+  }  // binary_nbest_type::read_uint()
+
+  static bool read_string(std::istream& is, std::string& s) {
+    unsigned size;
+    if (!read_uint(is, size))
+      return false;
+    s.resize(size);
+    return size == 0 || is.read(&s[0], size);
+  }  // binary_nbest_type::read_string()
+
+  static bool read_double(std::istream& is, double& d) {
+    unsigned char bytes[8];
+    if (!is.read(reinterpret_cast<char*>(bytes), 8))
+      return false;
+    unsigned long long bits = 0;
+    for (int i = 7; i >= 0; --i)
+      bits = (bits << 8) | bytes[i];
+    assert(sizeof(d) == sizeof(bits));
+    std::memcpy(&d, &bits, sizeof(d));
+    return true;
+  }  // binary_nbest_type::read_double()
+
+  //! read() reads the string and node tables (which follow the
+  //! sentence's label)
+  //
+  std::istream& read(std::istream& is) {
+    unsigned nstrings, nnodes;
+    if (!read_uint(is, nstrings))
+      return is;
+    strings.resize(nstrings);
+    for (unsigned i = 0; i < nstrings; ++i)
+      if (!read_string(is, strings[i]))
+	return is;
+    if (!read_uint(is, nnodes))
+      return is;
+    nodes.resize(nnodes);
+    for (unsigned i = 0; i < nnodes; ++i) {
+      node_type& node = nodes[i];
+      unsigned label, n;
+      if (!read_uint(is, label) || !read_uint(is, n))
+	return is;
+      node.label = label >> 1;
+      node.preterminal = label & 1;
+      if (node.preterminal)
+	node.word = n;
+      else {
+	node.children.resize(n);
+	for (unsigned j = 0; j < n; ++j)
+	  if (!read_uint(is, node.children[j]))
+	    return is;
+      }
+      // labels and words are in the string table and children come first
+      bool ok = node.label < nstrings 
+	&& (!node.preterminal || node.word < nstrings);
+      for (unsigned j = 0; j < node.children.size(); ++j)
+	ok = ok && node.children[j] < i;
+      if (!ok) {
+	std::cerr << HERE << "\n## Error: bad node in binary n-best list." << std::endl;
+	is.setstate(std::ios::failbit);
+	return is;
+      }
+    }
+    return is;
+  }  // binary_nbest_type::read()
+
+  //! node_tree() returns a new tree for node i, the same tree as reading
+  //! its text form would produce
+  //
+  tree* node_tree(unsigned i) const {
+    const node_type& node = nodes[i];
+    if (node.preterminal)
+      return new tree(tree::label_type::cat_type(strings[node.label]),
+		      new tree(tree::label_type::cat_type(strings[node.word])));
+    tree* children = NULL;
+    for (size_t j = node.children.size(); j > 0; --j) {
+      tree* child = node_tree(node.children[j-1]);
+      child->next = children;
+      children = child;
+    }
+    return new tree(tree::label_type::cat_type(strings[node.label]), children);
+  }  // binary_nbest_type::node_tree()
+
+};  // binary_nbest_type{}
+
 // parse_type{} holds the data for a single parse.  It has a pointer
 // to the parse tree, but someone else must free it when it is deleted!
 //
@@ -107,6 +248,43 @@ struct sp_parse_type {
     return is;
   }  // read_nbest()
 
+  //! read() reads a parse of a binary n-best list (its log probability
+  //! and root node) whose tables are in nbest
+  //
+  std::istream& read(std::istream& is, const binary_nbest_type& nbest,
+		     bool downcase_flag=false) {
+    double logprob0;
+    unsigned root;
+    if (binary_nbest_type::read_double(is, logprob0)
+	&& binary_nbest_type::read_uint(is, root)) {
+      if (root >= nbest.nodes.size()) {
+	std::cerr << HERE << "\n## Error: bad root in binary n-best list." << std::endl;
+	is.setstate(std::ios::failbit);
+	return is;
+      }
+      logprob = logprob0;
+      ASSERT(finite(logprob));
+      parse0 = nbest.node_tree(root);
+      parse0->label.cat = tree::label_type::root();
+      parse = tree_sptree(parse0, downcase_flag);
+      assert(parse != NULL);
+    }
+    return is;
+  }  // sp_parse_type::read()
+
+  //! set() builds this parse directly from one of the first-stage
+  //! parser's trees, as read() would from its printed form
+  //
+  template <typename parser_tree_type>
+  void set(Float logprob0, parser_tree_type* tp, bool downcase_flag=false) {
+    logprob = logprob0;
+    ASSERT(finite(logprob));
+    parse0 = parser_tree_tree(tp);
+    parse0->label.cat = tree::label_type::root();
+    parse = tree_sptree(parse0, downcase_flag);
+    assert(parse != NULL);
+  }  // sp_parse_type::set()
+
 };  // sp_parse_type{}
 
 
@@ -264,8 +442,9 @@ struct sp_sentence_type {
   //! produced by Eugene Charniak's or Slav Petrov's n-best parser.
   //! It determines which to read by looking at the first character
   //! of the output.  If it begins with a '-' then we assume it is
-  //! produced by Slav's parser, otherwise we assume it is produced
-  //! by Eugene's parser.
+  //! produced by Slav's parser, if it is binary_nbest_type::magic
+  //! it is Eugene's parser's binary format (parseIt -b), otherwise
+  //! we assume it is produced by Eugene's parser.
   //
   std::istream& read(std::istream& is, bool downcase_flag=false) {
     clear();
@@ -281,6 +460,8 @@ struct sp_sentence_type {
 
     is.unget();
     
+    if (c == binary_nbest_type::magic)
+      return read_binary(is, downcase_flag);
     if (c == '-' || c == '0') { // Petrov-style Berkeley parser output
       if (nblanklines == 0) {
 	std::string line;
@@ -331,6 +512,52 @@ struct sp_sentence_type {
     return is;
   }  // sp_sentence_type::read()
 
+  //! read_binary() reads one sentence in the binary n-best format
+  //
+  std::istream& read_binary(std::istream& is, bool downcase_flag=false) {
+    char magic, version;
+    is.get(magic);
+    is.get(version);
+    if (is && version != binary_nbest_type::version) {
+      std::cerr << HERE << "\n## Error: unknown binary n-best format version "
+		<< int(version) << std::endl;
+      is.setstate(std::ios::failbit);
+    }
+    binary_nbest_type nbest;
+    unsigned nparses;
+    if (!binary_nbest_type::read_string(is, label) || !nbest.read(is)
+	|| !binary_nbest_type::read_uint(is, nparses))
+      return is;
+    parses.resize(nparses);
+    for (size_t i = 0; i < nparses; ++i) {
+      parses[i].read(is, nbest, downcase_flag);
+      ASSERT(is);
+      ASSERT(parses[i].parse != NULL);
+    }
+    if (!parses.empty())
+      set_logcondprob();
+    return is;
+  }  // sp_sentence_type::read_binary()
+
+  //! set() fills this in from the first-stage parser's n-best list,
+  //! a sequence of (log prob, tree) pairs such as a vector<ScoredTree>.
+  //! The result is the same as read() on the parser's printed n-best
+  //! list, but no text is produced or parsed.
+  //
+  template <typename scored_trees_type>
+  void set(const scored_trees_type& scored_trees, const std::string& label0,
+	   bool downcase_flag=false) {
+    clear();
+    label = label0;
+    parses.resize(scored_trees.size());
+    size_t i = 0;
+    for (typename scored_trees_type::const_iterator it = scored_trees.begin();
+	 it != scored_trees.end(); ++it, ++i)
+      parses[i].set(it->first, it->second, downcase_flag);
+    if (!parses.empty())
+      set_logcondprob();
+  }  // sp_sentence_type::set()
+
   //! read() reads a set of trees from parsestream and the corresponding tree
   //! from goldstream.
   //
@@ -19,6 +19,7 @@
 %include "std_except.i"
 %include "std_vector.i"
 %include "std_string.i"
+%include "std_pair.i"
 %include "exception.i"
 
 #ifdef SWIGPYTHON
@@ -41,8 +42,35 @@
     }
 }
 
+#ifdef SWIGPYTHON
+%{
+    // releases the GIL for the lifetime of the object (and reacquires
+    // it even if the wrapped call throws)
+    class ReleaseGIL {
+        public:
+            ReleaseGIL() : state(PyEval_SaveThread()) {}
+            ~ReleaseGIL() { PyEval_RestoreThread(state); }
+        private:
+            PyThreadState* state;
+    };
+%}
+
+// scoreBatch() runs entirely in native worker threads so other Python
+// threads can run while it works
+%exception scoreBatch {
+    try {
+        ReleaseGIL releaseGIL;
+        $action
+    } catch (RerankerError re) {
+        SWIG_exception(SWIG_RuntimeError, re.description.c_str());
+    }
+}
+#endif
+
 %newobject readNBestList;
+%newobject convertNBestList;
 %newobject scoreNBestList;
+%newobject scoreBatch;
 
 %inline {
     #include <cstddef>
@@ -64,6 +92,12 @@
     };
     sp_sentence_type* readNBestList(const std::string nbest_list, bool lowercase);
 
+    // n-best lists from the parser module (vector<ScoredTree> there)
+    class InputTree;
+    typedef std::pair<double,InputTree*> ScoredTree;
+    sp_sentence_type* convertNBestList(const std::vector<ScoredTree>& scored_trees,
+            const std::string label, bool lowercase);
+
     class RerankerModel {
         public:
             Id maxid;
@@ -72,9 +106,18 @@
                     const char* feature_ids_filename,
                     const char* feature_weights_filename);
             Weights* scoreNBestList(const sp_sentence_type& nbest_list) const;
+            std::vector<Weights>* scoreBatch(
+                    const std::vector<std::vector<ScoredTree> >& nbest_lists,
+                    bool lowercase, int num_threads) const;
     };
 
     void setOptions(int debug, bool abs_counts);
 }
 
 %template(Weights) std::vector<Float>;
+// the same type as the parser module's VectorScoredTree, so
+// convertNBestList() accepts the n-best lists it returns
+%template(VectorScoredTree) std::vector<ScoredTree>;
+// likewise for parseBatch()'s VectorVectorScoredTree and scoreBatch()
+%template(VectorVectorScoredTree) std::vector<std::vector<ScoredTree> >;
+%template(WeightsVector) std::vector<Weights>;
@@ -25,6 +25,7 @@
 
 #include "sym.h"
 #include <cctype>
+#include <pthread.h>
 
 #define ESCAPE     '\\'
 #define OPENQUOTE  '\"'
@@ -39,12 +40,23 @@ symbol::Table& symbol::table()
   return table_;
 }
 
-symbol::symbol(const std::string& s) : sp(&*(table().insert(s).first)) { };
+// symbols may be constructed from several threads at once (e.g., by
+// the rerank stage of parseAndRerank), so table insertions are locked
+//
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+symbol::symbol(const std::string& s) {
+  pthread_mutex_lock(&table_lock);
+  sp = &*(table().insert(s).first);
+  pthread_mutex_unlock(&table_lock);
+}
 
 symbol::symbol(const char* cp) { 
   if (cp) {
     std::string s(cp); 
+    pthread_mutex_lock(&table_lock);
     sp = &*(table().insert(s).first);
+    pthread_mutex_unlock(&table_lock);
   }
   else
     sp = NULL;
@@ -1355,17 +1355,16 @@ struct precrec_type {
     symbol cat() const { return second; }
   };
 
-  struct edges : public std::map<edge, unsigned int> {
+  //! edges{} is the bag of a tree's edges, kept as a sorted vector with
+  //! one entry per occurrence, so that scoring a parse against the gold
+  //! edges is a single merge over two flat arrays.
+  //
+  struct edges : public std::vector<edge> {
     edges() { }
     template <typename Tree>
     edges(const Tree* t) { tree_nontermedges(t, *this); }
 
-    unsigned int nedges() const {
-      unsigned int n = 0;
-      for (const_iterator it = begin(); it != end(); ++it)
-	n += it->second;
-      return n;
-    }  // precrec_type::edges::nedges()
+    unsigned int nedges() const { return size(); }
 
   };  // precrec_type::edges{}
 
@@ -1377,13 +1376,19 @@ struct precrec_type {
     return cat == prt ? advp : cat;
   }
 
-  //! tree_nontermedges() maps a tree to its nonterminal edges, ignoring punctuation
-  //! and empty nodes as described in the EVALB documentation.
+  //! tree_nontermedges() adds a tree's nonterminal edges to es, ignoring 
+  //! punctuation and empty nodes as described in the EVALB documentation,
+  //! and leaves es sorted.
   //
   template <typename Tree>
-  static unsigned int tree_nontermedges(const Tree* t, edges& es, 
-					unsigned int left = 0, 
-					bool nonrootnode = false) {
+  static void tree_nontermedges(const Tree* t, edges& es) {
+    tree_nontermedges_(t, es, 0, false);
+    std::sort(es.begin(), es.end());
+  }  // precrec_type::tree_nontermedges()
+
+  template <typename Tree>
+  static unsigned int tree_nontermedges_(const Tree* t, edges& es, 
+					 unsigned int left, bool nonrootnode) {
 
     static const tree_label::catset_type punctuation(", : `` '' .");
 
@@ -1398,32 +1403,33 @@ struct precrec_type {
   
     unsigned int right = left;
     for (const Tree* c = t->child; c; c = c->next) 
-      right = tree_nontermedges(c, es, right, true);
+      right = tree_nontermedges_(c, es, right, true);
 
     if (nonrootnode && right > left)      // ignore root node and empty nodes
-      ++es[edge(left, right, relabel_category(t->label.cat))];
+      es.push_back(edge(left, right, relabel_category(t->label.cat)));
     
     return right;
-  }  // precrec_type::tree_nontermedges()
+  }  // precrec_type::tree_nontermedges_()
 
   // operator() scores two sets of edges and accumulates the scores.
+  // Both are sorted, so equal edges are adjacent and each gold edge
+  // matches at most one test edge.
   //
   precrec_type& operator()(const edges& goldedges, const edges& testedges) {
     edges::const_iterator git = goldedges.begin(), tit = testedges.begin();
-    while (git != goldedges.end() && tit != testedges.end()) 
-      if (git->first == tit->first) { // gold and test edges match
-	ncommon += std::min(git->second, tit->second);
-	ngold += git++->second;      
-	ntest += tit++->second;
+    const edges::const_iterator gend = goldedges.end(), tend = testedges.end();
+    while (git != gend && tit != tend) 
+      if (*git < *tit)
+	++git;
+      else if (*tit < *git)
+	++tit;
+      else {                            // gold and test edges match
+	++ncommon;
+	++git;
+	++tit;
       }
-      else if (git->first < tit->first) 
-	ngold += git++->second;
-      else 
-	ntest += tit++->second;
-    while (git != goldedges.end()) 
-      ngold += git++->second;
-    while (tit != testedges.end()) 
-      ntest += tit++->second;
+    ngold += goldedges.size();
+    ntest += testedges.size();
     return *this;
   }  // precrec_type::operator()
 
@@ -24,6 +24,7 @@
 #include <cstring>
 #include <map>
 #include <iostream>
+#include <sstream>
 #include <unistd.h>
 #include <vector>
 
@@ -38,11 +39,17 @@ const char usage[] =
 "\n"
 "Usage: gavper [-a] [-b burnin] [-d debug] [-F] [-g] [-m nseps] [-n nepochs]\n"
 "    [-o outfile] [-c c0] [-f feat.gz] [-e evalfile] [-x evalfile2]\n"
-"    [-r reduce] [-s randseed] < traindata\n"
+"    [-r reduce] [-s randseed] [-w wepochs] [-C cachefile] < traindata\n"
 "\n"
 "where:\n"
 "\n"
 " -a          - start with log prob feature class and add features,\n"
+" -C cachefile - file in which the f-score of each set of feature class\n"
+"               weights is kept, so rerunning with the same options and\n"
+"               data doesn't retrain on the weights evaluated before\n"
+"               (with -w, f-scores depend on which parents' weights were\n"
+"               kept, so a rerun reuses the earlier run's f-scores\n"
+"               rather than reproducing its own),\n"
 " -b burnin   - the number of epochs before averaging begins,\n"
 " -c c0       - initial feature class factors,\n"
 " -d debug    - an integer which controls debugging output,\n"
@@ -54,8 +61,13 @@ const char usage[] =
 " -n nepochs  - the number of training epochs,\n"
 " -o outfile  - file to which trained feature weights are written,\n"
 " -r reduce   - factor at which the learning rate is decreased each epoch,\n"
-" -s randseed - random number seed, and\n"
-" -x evalfile2 - 2nd evaluation file\n";
+" -s randseed - random number seed,\n"
+" -w wepochs  - train each set of feature class weights for wepochs epochs\n"
+"               (without burn-in) starting from the weights trained for the\n"
+"               set it was derived from, rather than from zero, and\n"
+" -x evalfile2 - 2nd evaluation file\n"
+"\n"
+"The sets of feature class weights are trained on OMP_NUM_THREADS threads.\n";
 
 int debug_level = 0;
 
@@ -110,6 +122,8 @@ struct Estimator1 {
   Float burnin; 
   Float nepochs; 
   Float reduce;
+  Float wepochs;        //!< epochs when starting from another's weights
+  unsigned randseed;
 
   Float best_fscore;    //!< best f-score seen so far
 
@@ -127,20 +141,29 @@ struct Estimator1 {
   typedef std::vector<std::string> Ss;
   Ss regclass_identifiers; //!< vector of class identifiers
 
+  greedy_memo<doubles> memo;  //!< class factors -> 1 - f-score
+
   Estimator1(corpus_type* train, corpus_type* eval, corpus_type* eval2,
 	     bool addfeats, double c0, Float burnin, Float nepochs, 
-	     Float reduce,
+	     Float reduce, Float wepochs, unsigned randseed,
 	     const char* weightsfile = NULL) 
     : train(train), nx(train->nfeatures), eval(eval), eval2(eval2),
       addfeats(addfeats), c0(c0), burnin(burnin), nepochs(nepochs), 
-      reduce(reduce), best_fscore(0), f_c(nx), cs(1, 1), nc(1), 
+      reduce(reduce), wepochs(wepochs), randseed(randseed),
+      best_fscore(0), f_c(nx), cs(1, 1), nc(1), 
       nrounds(0), 
       weightsfile(weightsfile == NULL ? "" : weightsfile)
   { }  // Estimator1::Estimator1()
 
-  // operator() actually runs one round of estimation
+  //! the feature weights trained for a set of class factors, which
+  //! greedy() passes back when training on a set derived from it
+  typedef doubles state_type;
+
+  // operator() actually runs one round of estimation.  The weights
+  // start from x0 if it isn't NULL and wepochs is set, and are left in
+  // x1 in that case.
   //
-  double operator() (const doubles& ccs) {
+  double operator() (const doubles& ccs, const doubles* x0, doubles& x1) {
     assert(ccs.size() == nc);
 
     size_type round;
@@ -149,9 +172,22 @@ struct Estimator1 {
     if ((round = ++nrounds) == 1 && debug_level >= 10) 
 	std::cout << "# round f-score(s) ccs" << std::endl;
 
+    // each round draws its sentences from its own generator, seeded by
+    // its class factors, so its result doesn't depend on which rounds
+    // run alongside it
+    unsigned seed = randseed ^ ext::hash<doubles>()(ccs);
+
     doubles x(nx);
-    
-    avper(burnin, nepochs, reduce, &x[0], &f_c[0], &ccs[0]);
+    if (x0 != NULL && wepochs > 0) {
+      assert(x0->size() == nx);
+      x = *x0;
+      for (size_type j = 0; j < nx; ++j)   // drop the classes this set leaves out
+	if (ccs[f_c[j]] == 0)
+	  x[j] = 0;
+      avper(0, wepochs, reduce, &x[0], &f_c[0], &ccs[0], seed);
+    }
+    else
+      avper(burnin, nepochs, reduce, &x[0], &f_c[0], &ccs[0], seed);
 
     std::vector<double> df_dx(nx);
     Float sum_g = 0, sum_p = 0, sum_w = 0;
@@ -189,6 +225,8 @@ struct Estimator1 {
 	}      
       }
     }
+    if (wepochs > 0)
+      x1.swap(x);
     return 1 - fscore;
   }  // Estimator1::operator()
 
@@ -199,7 +237,8 @@ struct Estimator1 {
 	     Float r,                     //!< discount factor per epoch
 	     Float w[],                   //!< weight vector
 	     size_type feat_class[],      //!< feature -> class
-	     const double class_factor[]  //!< class -> class weight factor
+	     const double class_factor[], //!< class -> class weight factor
+	     unsigned seed                //!< random number seed
 	     )
   {
     double dw = 1.0;
@@ -217,7 +256,7 @@ struct Estimator1 {
 
     if (b > 0) {
       for (size_type it = 0; it < b * train->nsentences; ++it) {
-	index = size_t(rfactor*random());
+	index = size_t(rfactor*rand_r(&seed));
 	assert(index < train->nsentences);
 	if (train->sentence[index].Px > 0)
 	  wap_sentence(&train->sentence[index], w, dw, feat_class, class_factor,
@@ -239,7 +278,7 @@ struct Estimator1 {
     
     size_type it;
     for (it = 0; it < n * train->nsentences; ++it) {
-      index = size_t(rfactor*random());
+      index = size_t(rfactor*rand_r(&seed));
       assert(index < train->nsentences);
       dw *= ddw;
       if (train->sentence[index].Px > 0)
@@ -431,6 +470,10 @@ struct Estimator1 {
     if (debug_level >= 0) 
       std::cout << "# Regularization classes: " << regclass_identifiers << std::endl;
 
+    // group each training parse's features by class, so that training
+    // with some classes' factors 0 never visits those classes' features
+    corpus_partition_classes(train, &f_c[0], nc);
+
     if (popen_flag)
       pclose(in);
     else
@@ -439,7 +482,7 @@ struct Estimator1 {
     
   void estimate()
   {
-    greedy(*this, cs);
+    greedy(*this, cs, memo);
     
     if (debug_level > 0) 
       std::cout << "# Regularizer class weights = " << cs << std::endl;
@@ -462,17 +505,22 @@ int main(int argc, char **argv)
   Float Pyx_f = 0;
   bool Px_g = 0;
   size_t randseed = 0;
+  Float wepochs = 0;
+  char *cachefile = NULL;
 
   opterr = 0;
   
   int c;
   char *cp;
 
-  while ((c = getopt(argc, argv, "ab:c:d:e:F:gf:m:n:o:r:s:x:")) != -1)
+  while ((c = getopt(argc, argv, "ab:C:c:d:e:F:gf:m:n:o:r:s:w:x:")) != -1)
     switch (c) {
     case 'a':
       addfeats = true;
       break;
+    case 'C':
+      cachefile = optarg;
+      break;
     case 'b':
       burnin = strtod(optarg, &cp);
       if (cp == NULL || *cp != '\0')
@@ -524,6 +572,11 @@ int main(int argc, char **argv)
 	exit_failure("Expected a positive argument for -s, saw ", optarg);
       srandom(randseed);  // reset the random seed
       break;
+    case 'w':
+      wepochs = strtod(optarg, &cp);
+      if (cp == NULL || *cp != '\0')
+	exit_failure("Expected a float argument for -w, saw ", optarg);
+      break;
     case 'x':
       evalfile2 = optarg;
       break;
@@ -543,6 +596,7 @@ int main(int argc, char **argv)
 	      << ", Px_g = " << Px_g
 	      << ", nseparators = " << nseparators
 	      << ", nepochs = " << nepochs 
+	      << ", wepochs = " << wepochs 
 	      << ", reduce = " << reduce 
 	      << ", randseed = " << randseed
 	      << ", featfile = " << featfile
@@ -568,11 +622,27 @@ int main(int argc, char **argv)
   }
 
   Estimator1 e(traindata, evaldata, evaldata2, addfeats, c0, 
-	       burnin, nepochs, reduce, outfile);
+	       burnin, nepochs, reduce, wepochs, randseed, outfile);
 
   if (featfile != NULL)
     e.read_featureclasses(featfile, nseparators, ":");   // number of separators
 
+  if (cachefile != NULL) {
+    // everything the f-score of a set of class factors depends on
+    std::ostringstream id;
+    id << "gavper -b " << burnin << " -n " << nepochs << " -w " << wepochs
+       << " -r " << reduce << " -F " << Pyx_f << " -g " << Px_g 
+       << " -m " << nseparators << " -s " << randseed
+       << " -f " << (featfile ? featfile : "-") 
+       << " -e " << (evalfile ? evalfile : "-")
+       << ", " << traindata->nsentences << " training sentences with " 
+       << nx << " features";
+    if (!e.memo.open(cachefile, id.str()))
+      exit_failure("Can't use cache file ", cachefile);
+    if (debug_level >= 10)
+      std::cout << "# Read " << e.memo.size() << " f-scores from " << cachefile << std::endl;
+  }
+
   e.estimate();
 
 }  // main()
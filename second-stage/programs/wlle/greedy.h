@@ -16,49 +16,351 @@
 
 #include "custom_allocator.h"  // must be first
 
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <ext/hash_map>
 #include <ext/hash_set>
 #include "pqueue.h"
 
-//! greedy() does a greedy search on xs.
-//! xs should be a binary vector; its elements will
-//! be set to 0 or 1 to turn elements on or off
-//! in order to minimize f(xs).
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//! greedy_memo{} remembers f(xs) for each xs evaluated, and if opened
+//! on a file keeps them there too, so a search that is stopped (or
+//! rerun with a different number of threads) doesn't evaluate any xs
+//! twice.  The file starts with a line identifying what f is (e.g.,
+//! the options and data it was run with); opening a file made for a
+//! different f is an error.  Values f computed from a parent's state
+//! depend on which states were kept, and so on scheduling; they are
+//! kept too, so a rerun picks up the values of the run that wrote
+//! them rather than reproducing its own.  xs_type should be a vector
+//! of doubles.
+//
+template <typename xs_type>
+class greedy_memo {
+  typedef double Float;
+  typedef ext::hash_map<xs_type,Float> XS_F;
+  XS_F xs_fxs;
+  FILE* out;
+
+public:
+  greedy_memo() : out(NULL) { }
+  ~greedy_memo() { if (out != NULL) fclose(out); }
+
+  //! open() reads the values stored in filename, if it exists, and
+  //! appends each new value to it.  It returns false if filename
+  //! can't be opened or was made for something other than id.
+  //
+  bool open(const char* filename, const std::string& id) {
+    FILE* in = fopen(filename, "r");
+    if (in != NULL) {
+      std::string header;
+      int c;
+      while ((c = getc(in)) != EOF && c != '\n')
+	header.push_back(c);
+      if (header != "# " + id) {
+	std::cerr << "## Error: " << filename << " was made by " << header
+		  << ", not # " << id << std::endl;
+	fclose(in);
+	return false;
+      }
+      Float fxs;
+      size_t n;
+      while (fscanf(in, " %lf %zu", &fxs, &n) == 2) {
+	xs_type xs(n);
+	for (size_t i = 0; i < n; ++i)
+	  if (fscanf(in, " %lf", &xs[i]) != 1) {
+	    std::cerr << "## Error: " << filename << " is truncated" << std::endl;
+	    fclose(in);
+	    return false;
+	  }
+	xs_fxs[xs] = fxs;
+      }
+      fclose(in);
+    }
+    out = fopen(filename, "a");
+    if (out == NULL)
+      return false;
+    if (in == NULL) {
+      fprintf(out, "# %s\n", id.c_str());
+      fflush(out);
+    }
+    return true;
+  }  // greedy_memo::open()
+
+  //! find() sets fxs to f(xs) and returns true if xs has been evaluated
+  //
+  bool find(const xs_type& xs, Float& fxs) const {
+    typename XS_F::const_iterator it = xs_fxs.find(xs);
+    if (it == xs_fxs.end())
+      return false;
+    fxs = it->second;
+    return true;
+  }  // greedy_memo::find()
+
+  //! insert() records f(xs), writing it to the file too if open
+  //
+  void insert(const xs_type& xs, Float fxs) {
+    xs_fxs[xs] = fxs;
+    if (out != NULL) {
+      fprintf(out, "%.17g %zu", fxs, xs.size());
+      for (size_t i = 0; i < xs.size(); ++i)
+	fprintf(out, " %.17g", double(xs[i]));
+      fprintf(out, "\n");
+      fflush(out);
+    }
+  }  // greedy_memo::insert()
+
+  size_t size() const { return xs_fxs.size(); }
+
+};  // greedy_memo{}
+
+
+//! greedy_search{} does the search for greedy() below.
+//!
+//! Each xs evaluated is queued by f(xs), and the search repeatedly
+//! expands the best xs in the queue, i.e., queues the xs differing
+//! from it in one element for evaluation (best parent first).  Up to
+//! nthreads evaluations run at once as OpenMP tasks; a task takes the
+//! best waiting xs when it starts, so no thread waits for any other's
+//! evaluation to finish, and the lock on the search's state is only
+//! held while the queues are updated.
+//!
+//! f is called as f(xs, parent, state), where parent is NULL or points
+//! to the state f left for the xs this one was expanded from, so f can
+//! start from it (e.g., from its weights).  The states of at most
+//! maxstates unexpanded xs are kept (those of the best xs); an xs
+//! expanded without its state passes its children NULL.  f need not
+//! leave any state.
 //
 template <typename f_type, typename xs_type>
-void greedy(f_type& f, xs_type& xs) {
+class greedy_search {
   typedef double Float;
-  Float fxs = f(xs);
-  xs_type best_xs(xs);
-  Float best_fxs = fxs;
-  ext::hash_set<xs_type> cache;
-  cache.insert(xs);
-  pqueue<xs_type,Float> pq;
-  pq.set(xs, fxs);
-  while (!pq.empty()) {
-    xs_type xs0 = pq.top_key();
-    pq.pop();  // remove analysis
-# pragma omp parallel for default(shared)
-    for (int i = 0; i < int(xs0.size()); ++i) {  // flip bit i
+  typedef typename f_type::state_type state_type;
+
+  //! the state of an expanded xs, shared by its children until
+  //! they have all been evaluated
+  struct parent_type {
+    state_type state;
+    size_t nchildren;
+    parent_type() : nchildren(0) { }
+  };
+
+  typedef std::pair<Float,state_type*> F_S;
+  typedef ext::hash_map<xs_type,F_S> XS_FS;
+  typedef ext::hash_map<xs_type,parent_type*> XS_P;
+
+  f_type& f;
+  greedy_memo<xs_type>& memo;
+  size_t maxstates;
+  int nthreads;
+
+  ext::hash_set<xs_type> seen;       //!< xs queued or evaluated
+  pqueue<xs_type,Float> evaluated;    //!< unexpanded xs, by f(xs)
+  pqueue<xs_type,Float> waiting;      //!< xs to evaluate, by f(parent)
+  XS_P waiting_parent;                //!< xs to evaluate -> parent
+  XS_FS states;                       //!< unexpanded xs -> f(xs), state
+  int nrunning;                       //!< evaluations started but not done
+  int nreserved;                      //!< of those, how many haven't taken an xs
+
+#ifdef _OPENMP
+  omp_lock_t lock_;
+  void lock() { omp_set_lock(&lock_); }
+  void unlock() { omp_unset_lock(&lock_); }
+#else
+  void lock() { }
+  void unlock() { }
+#endif
+
+public:
+  xs_type best_xs;
+  Float best_fxs;
+
+  greedy_search(f_type& f, greedy_memo<xs_type>& memo, size_t maxstates, int nthreads) 
+    : f(f), memo(memo), maxstates(maxstates), nthreads(nthreads), 
+      nrunning(0), nreserved(0) {
+#ifdef _OPENMP
+    omp_init_lock(&lock_);
+#endif
+  }
+
+  ~greedy_search() {
+    for (typename XS_FS::iterator it = states.begin(); it != states.end(); ++it)
+      delete it->second.second;
+    for (typename XS_P::iterator it = waiting_parent.begin(); it != waiting_parent.end(); ++it)
+      if (it->second != NULL && --it->second->nchildren == 0)
+	delete it->second;
+#ifdef _OPENMP
+    omp_destroy_lock(&lock_);
+#endif
+  }
+
+  //! run() searches from xs
+  //
+  void run(const xs_type& xs) {
+    Float fxs;
+    state_type* state = new state_type;
+    if (!memo.find(xs, fxs)) {
+      fxs = f(xs, NULL, *state);
+      memo.insert(xs, fxs);
+    }
+    best_xs = xs;
+    best_fxs = fxs;
+    seen.insert(xs);
+    add_evaluated(xs, fxs, state);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) default(shared)
+#pragma omp single
+    spawn(reserve());
+#else
+    while (reserve() > 0)
+      evaluate();
+#endif
+  }  // greedy_search::run()
+
+private:
+
+  //! add_evaluated() queues xs for expansion, keeping state if there is one.
+  //! Called with the lock held.
+  //
+  void add_evaluated(const xs_type& xs, Float fxs, state_type* state) {
+    evaluated.set(xs, fxs);
+    if (fxs < best_fxs) {
+      best_fxs = fxs;
+      best_xs = xs;
+    }
+    if (state == NULL || state->empty()) {
+      delete state;
+      return;
+    }
+    states[xs] = F_S(fxs, state);
+    if (states.size() > maxstates) {  // forget the worst xs' state
+      typename XS_FS::iterator worst = states.begin();
+      for (typename XS_FS::iterator it = states.begin(); it != states.end(); ++it)
+	if (it->second.first > worst->second.first)
+	  worst = it;
+      delete worst->second.second;
+      states.erase(worst);
+    }
+  }  // greedy_search::add_evaluated()
+
+  //! expand() queues for evaluation the unseen xs differing from the
+  //! best evaluated xs in one element.  Those already in the memo
+  //! are queued for expansion straight away.  Called with the lock held.
+  //
+  void expand() {
+    xs_type xs0 = evaluated.top_key();
+    Float fxs0 = evaluated.top_priority();
+    evaluated.pop();
+    parent_type* parent = NULL;
+    typename XS_FS::iterator sit = states.find(xs0);
+    if (sit != states.end()) {
+      parent = new parent_type;
+      parent->state.swap(*sit->second.second);
+      delete sit->second.second;
+      states.erase(sit);
+    }
+    for (size_t i = 0; i < xs0.size(); ++i) {  // flip bit i
       xs_type xs1 = xs0;
       if (xs1[i] == 0)
 	xs1[i] = 1;
       else
 	xs1[i] = 0;
-      bool inserted;
-# pragma omp critical (greedy_cache0)
-      inserted = cache.insert(xs1).second;
-      if (inserted) {
-	Float fxs1 = f(xs1);
-# pragma omp critical (greedy_cache1)
-	{
-	  pq.set(xs1, fxs1);
-	  if (fxs1 < best_fxs) {
-	    best_fxs = fxs1;
-	    best_xs = xs1;
-	  }
-	}
+      if (!seen.insert(xs1).second)
+	continue;
+      Float fxs1;
+      if (memo.find(xs1, fxs1))
+	add_evaluated(xs1, fxs1, NULL);
+      else {
+	waiting.set(xs1, fxs0);
+	waiting_parent[xs1] = parent;
+	if (parent != NULL)
+	  ++parent->nchildren;
       }
-    }  // end for parallel region
+    }
+    if (parent != NULL && parent->nchildren == 0)
+      delete parent;
+  }  // greedy_search::expand()
+
+  //! reserve() returns how many more evaluations to start (so that
+  //! nthreads are running while there is anything to evaluate), and
+  //! counts them as running.
+  //
+  int reserve() {
+    lock();
+    while (int(waiting.size()) - nreserved < nthreads - nrunning && !evaluated.empty())
+      expand();
+    int nstart = std::min(nthreads - nrunning, int(waiting.size()) - nreserved);
+    nrunning += nstart;
+    nreserved += nstart;
+    unlock();
+    return nstart;
+  }  // greedy_search::reserve()
+
+  //! evaluate() evaluates the best waiting xs
+  //
+  void evaluate() {
+    lock();
+    assert(!waiting.empty());
+    xs_type xs = waiting.top_key();
+    waiting.pop();
+    --nreserved;
+    typename XS_P::iterator pit = waiting_parent.find(xs);
+    assert(pit != waiting_parent.end());
+    parent_type* parent = pit->second;
+    waiting_parent.erase(pit);
+    unlock();
+
+    state_type* state = new state_type;
+    Float fxs = f(xs, parent == NULL ? NULL : &parent->state, *state);
+
+    lock();
+    memo.insert(xs, fxs);
+    add_evaluated(xs, fxs, state);
+    if (parent != NULL && --parent->nchildren == 0)
+      delete parent;
+    --nrunning;
+    unlock();
+  }  // greedy_search::evaluate()
+
+  //! task() is the OpenMP task that does one evaluation
+  //
+  void task() {
+    evaluate();
+    spawn(reserve());
+  }  // greedy_search::task()
+
+  void spawn(int ntasks) {
+    for (int i = 0; i < ntasks; ++i) {
+#pragma omp task default(shared)
+      task();
+    }
+  }  // greedy_search::spawn()
+
+};  // greedy_search{}
+
+
+//! greedy() does a greedy search on xs.
+//! xs should be a binary vector; its elements will
+//! be set to 0 or 1 to turn elements on or off
+//! in order to minimize f(xs).  See greedy_search{}
+//! for how f is called.
+//
+template <typename f_type, typename xs_type>
+void greedy(f_type& f, xs_type& xs, greedy_memo<xs_type>& memo, 
+	    size_t maxstates = 8, int nthreads = 0) {
+  if (nthreads <= 0) {
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#else
+    nthreads = 1;
+#endif
   }
-  xs = best_xs;
+  greedy_search<f_type,xs_type> search(f, memo, maxstates, nthreads);
+  search.run(xs);
+  xs = search.best_xs;
 }
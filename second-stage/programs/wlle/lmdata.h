@@ -57,11 +57,26 @@ typedef struct {
   DataFloat c;                /* number of times feature occured */
 } fc_type;
 
+/*! classrun_type{} describes a parse's features in one feature class,
+ *! once corpus_partition_classes() has grouped them by class.  The
+ *! class' features with count 1 are f[f_begin..f_end) and its feature
+ *! counts fc[fc_begin..fc_end), where f_begin and fc_begin are the
+ *! previous run's ends (0 for the first run).
+ */
+
+typedef struct {
+  size_type c;                /* feature class */
+  size_type f_end;            /* end of the class' features with count 1 */
+  size_type fc_end;           /* end of the class' feature counts */
+} classrun_type;
+
 typedef struct {
   feature_type *f;            /* array of features with count 1 */
   size_type  nf;              /* number of features with count 1 */
   fc_type *fc;                /* array of feature counts */
   size_type  nfc;             /* number of feature counts */
+  classrun_type *run;         /* runs of features by class, NULL if not partitioned */
+  size_type  nruns;           /* number of runs, i.e., classes with features */
   DataFloat   Pyx;            /* probability this parse is correct, 0 when not correct */
   DataFloat   p;	      /* number of parse edges */
   DataFloat   w;	      /* number of correct parse edges */
@@ -98,6 +113,14 @@ corpus_type *read_corpus(corpusflags_type *flags, FILE *in);
 
 corpus_type *read_corpus_file(corpusflags_type *flags, const char* filename);
 
+/*! corpus_partition_classes() sorts each parse's features by their
+ *! class feat_class[f] (< nclasses) and sets its class runs, so that
+ *! functions given class weights can skip the classes weighted 0.
+ */
+
+void corpus_partition_classes(corpus_type *c, const size_type feat_class[], 
+			      size_type nclasses);
+
 
 /***********************************************************************
  *                                                                     *
@@ -229,6 +252,10 @@ void ap_sentence(sentence_type *s, Float w[], Float dw, Float weightdecay,
  *!  sum_w      - cumulative sum of weight vectors
  *!  it         - current iteration
  *!  changed[k] - iteration at which w[k] was last changed
+ *!
+ *! If s has been partitioned by feat_class (see corpus_partition_classes()),
+ *! the features of classes with class_dw 0 are neither scored nor updated
+ *! (their weights should be 0).
  */
 
 void wap_sentence(sentence_type *s, Float w[], 
@@ -249,7 +276,7 @@ void wap_sentence(sentence_type *s, Float w[],
 typedef struct {
   Float *w1;            /*!< level 1 weights: w1[nhidden]            */
   Float *b0;            /*!< level 0 biases:  b0[nhidden]            */
-  Float *w0;            /*!< level 0 weights: w0[nhidden][nfeatures] */
+  Float *w0;            /*!< level 0 weights: w0[nfeatures][nhidden] */
 } lnn_weights_type;
 
 /*! lnn_unpack_weights_type() sets a lnn_weights_type to point to the appropriate
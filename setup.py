@@ -94,14 +94,15 @@ maybe_run_swig(parser_wrapper_full, 'CharniakParser', parser_base,
 
 parser_sources = (wrapper_path, 'Bchart.C', 'BchartSm.C', 'Bst.C',
                   'FBinaryArray.C', 'CntxArray.C', 'ChartBase.C',
-                  'ClassRule.C', 'ECArgs.C', 'Edge.C', 'EdgeHeap.C',
-                  'ExtPos.C', 'Feat.C', 'Feature.C', 'FeatureTree.C',
-                  'Field.C', 'FullHist.C', 'GotIter.C', 'InputTree.C',
+                  'ClassRule.C', 'DecodePool.C', 'ECArgs.C', 'Edge.C',
+                  'EdgeHeap.C', 'ExtPos.C', 'Feat.C', 'Feature.C',
+                  'FeatureTree.C', 'Field.C', 'FullHist.C', 'GotIter.C',
+                  'InputTree.C',
                   'Item.C', 'Link.C', 'Params.C', 'ParseStats.C',
-                  'SentRep.C', 'ScoreTree.C', 'Term.C', 'TimeIt.C',
-                  'UnitRules.C', 'ValHeap.C', 'edgeSubFns.C',
-                  'ewDciTokStrm.C', 'extraMain.C', 'fhSubFns.C',
-                  'headFinder.C', 'headFinderCh.C', 'utils.C',
+                  'ParserModel.C', 'SentRep.C', 'ScoreTree.C', 'Term.C',
+                  'TimeIt.C', 'UnitRules.C', 'ValHeap.C', 'WordPlistCache.C',
+                  'edgeSubFns.C', 'ewDciTokStrm.C', 'extraMain.C',
+                  'fhSubFns.C', 'headFinder.C', 'headFinderCh.C', 'utils.C',
                   'MeChart.C', 'Fusion.C')
 parser_sources = [join(parser_base, src) for src in parser_sources]
 
@@ -133,6 +134,7 @@ reranker_sources = [join(reranker_base, src) for src in
 reranker_module = Extension('bllipparser._JohnsonReranker',
                             sources=reranker_sources,
                             extra_compile_args=['-iquote', reranker_base,
+                                                '-iquote', parser_base,
                                                 '-DSWIGFIX', '-std=c++11'])
 
 setup(name='bllipparser',